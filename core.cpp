@@ -25,18 +25,18 @@
 
 namespace core {
 
-  /// Stack /////////////////////////////
+  /// History ///////////////////////////
 
-  bool Stack::is_repetition() const {
+  bool History::is_repetition() const {
 
-    if (size() < 5)
+    if (size_ < 5)
       return false;
 
-    int begin = size() - 3;
-    int end   = size() - 1 - back().r50();
+    int begin = size_ - 3;
+    int end   = size_ - 1 - back().state.r50();
 
     for (int i = begin; i > end && i >= 0; i -= 2) {
-      if (back().key(true) == (*this)[i].key(true))
+      if (back().state.key(true) == r_[i].state.key(true))
         return true;
     }
     return false;
@@ -46,19 +46,13 @@ namespace core {
 
   void Pos::set(const std::string& fen) {
 
-    undo_stack.reset();
+    hist_.reset();
     pst_.clear();
 
     sqrs_.fill(0);
     bb_.fill(0);
     cb_.fill(0);
 
-    move_stack_.clear();
-    move_stack_.reserve(1024);
-
-    cp_stack_.clear();
-    cp_stack_.reserve(1024);
-
     std::stringstream ss(fen);
     std::string str[] = { "", "", "", "" };
 
@@ -70,12 +64,9 @@ namespace core {
 
     state().set_r50(r50);
 
-    // add 2 pseudo-half-moves for every Move
-    // to sync the half-move clock and 50 moves state
-    for (auto i = 1; i < ply_; i++) {
-      undo_stack.rem();
-      undo_stack.rem();
-    }
+    // 2 half-moves for every move to sync the ply (no records)
+    if (ply_ > 1)
+      hist_.skip(2 * (ply_ - 1));
 
     // position
     int sq = 0;
@@ -103,7 +94,7 @@ namespace core {
 
     // side to move
     if (str[1] == "b")
-      undo_stack.rem();
+      hist_.rem();
   }
 
   // used for testing only
@@ -144,20 +135,22 @@ namespace core {
     state().set_cr(flip_cr);
 
     // stm
-    undo_stack.rem();
+    hist_.rem();
   }
 
   // followed Stockfish's pawn_eval ideas - https://stockfishchess.org/
   // my params are @most a good guess
+  // packed mg/eg, tapered with the pst @mix:
+  // x + (24 - phase) is (x, x + 24), x + (24 - phase) / 2 is (x, x + 12)
   template <bool S>
-  int Pos::ev_pawns() const {
+  pst::score_t Pos::ev_pawns() const {
 
+    using pst::make_score;
     static constexpr int con[] = { 0, 0, 2, 3, 5, 10, 15, 25, 0 };
     // static constexpr int con[] = { 0, 0, 2, 3, 5, 11, 18, 30, 0 };
+    static constexpr pst::score_t one = make_score(1, 1);
     bool bckw;
-    int sc  = 0;
-    int cph = 24 - pst_.phase();
-    int hph = cph >> 1;
+    pst::score_t sc = 0;
 
     int op_king = king_sq(!S);
 
@@ -186,20 +179,20 @@ namespace core {
 
       if (!(hood)) {
         if (oppo && dubl && !bool(stps))
-          sc -= 4 + cph;
+          sc -= make_score(4, 28);
         else
-          sc -= 2 + (6 + hph) * !bool(oppo);
+          sc -= make_score(2, 2) + make_score(6, 18) * !bool(oppo);
       } else if (phlx | supp) {
-        sc += con[rrank] * (2 + bool(phlx) - bool(oppo));
-        sc += 7 * supp.count();
-        sc += 7 - db::distance(sq, op_king);
+        sc += one * con[rrank] * (2 + bool(phlx) - bool(oppo));
+        sc += one * 7 * supp.count();
+        sc += one * (7 - db::distance(sq, op_king));
       } else if (bckw)
-        sc -= hph + (6 + hph) * !bool(oppo);
+        sc -= make_score(0, 12) + make_score(6, 18) * !bool(oppo);
       if (!supp)
-        sc -= (4 + cph) * bool(dubl) + bool(leve.count() > 1);
+        sc -= make_score(4, 28) * bool(dubl) + one * bool(leve.count() > 1);
       if (pssd) {
-        sc += (2 + phlx.count() + supp.count()) * con[rrank];
-        sc += db::distance(sq, op_king);
+        sc += one * (2 + phlx.count() + supp.count()) * con[rrank];
+        sc += one * db::distance(sq, op_king);
       }
       // at = pawn_atck<S>(sq);
       // sc += (u64(at & minor<!S>()).count() << 2)
@@ -232,11 +225,12 @@ namespace core {
   };
   // clang-format off
   template <bool S>
-  int Pos::ev_kngts(u64 ks) {
+  int Pos::ev_kngts(u64 ks, u64& atck) {
 
     int sc = 0;
     for (auto sq : kngt(S)) {
       u64 at = N_MASK[sq];
+      atck |= at;
       sc += (u64(at & CENTER4).count())
           + (u64(at & CENTER16).count() << 1)
           + (u64(at & ks).count() << 2)
@@ -247,11 +241,12 @@ namespace core {
     return sc;
   }
   template <bool S>
-  int Pos::ev_bsops(u64 ks) {
+  int Pos::ev_bsops(u64 ks, u64& atck) {
 
     int sc = 0;
     for (auto sq : bsop(S)) {
       u64 at = bsop_atck(sq);
+      atck |= at;
       sc += (u64(at & CENTER4).count())
           + (u64(at & CENTER16).count() << 1)
           + (u64(at & ks).count() << 2)
@@ -262,11 +257,12 @@ namespace core {
     return sc;
   }
   template <bool S>
-  int Pos::ev_rooks(u64 ks) {
+  int Pos::ev_rooks(u64 ks, u64& atck) {
 
     int sc = 0;
     for (auto sq : rook(S)) {
       u64 at = rook_atck(sq);
+      atck |= at;
       sc += (u64(at & CENTER4).count())
           + (u64(at & CENTER16).count() << 1)
           + (u64(at & ks).count() << 1)
@@ -277,11 +273,12 @@ namespace core {
     return sc;
   }
   template <bool S>
-  int Pos::ev_qeens(u64 ks) {
+  int Pos::ev_qeens(u64 ks, u64& atck) {
 
     int sc = 0;
     for (auto sq : qeen(S)) {
       u64 at = qeen_atck(sq);
+      atck |= at;
       sc += (u64(at & CENTER4).count())
           + (u64(at & CENTER16).count() << 1)
           + (u64(at & ks).count())
@@ -292,7 +289,8 @@ namespace core {
     return sc;
   }
   // clang-format on
-  int Pos::eval() {
+  // flatten: the ev_ terms are built with the clone's isa, too
+  [[gnu::flatten]] HOT int Pos::eval() {
     if (pst_.is_material_draw())
       return 0;
 
@@ -302,15 +300,20 @@ namespace core {
     // int qtr = ph >> 2; // [0 .. 6]
 
     u64 ks[N_CLR] = { kingspace(B_), kingspace(W_) };
+    // the attack maps of both sides fall out of the piece terms
+    u64 at[N_CLR] = { pawn_atcks<B_>() | ks[B_], pawn_atcks<W_>() | ks[W_] };
     // clang-format off
-    int sc = pst_.mix()
-          + ev_pawns<W_>() - ev_pawns<B_>()
-          + (ev_kngts<W_>(ks[B_]) - ev_kngts<B_>(ks[W_])
-           + ev_bsops<W_>(ks[B_]) - ev_bsops<B_>(ks[W_])
-           + ev_rooks<W_>(ks[B_]) - ev_rooks<B_>(ks[W_])
-           + ev_qeens<W_>(ks[B_]) - ev_qeens<B_>(ks[W_])) / 4;
+    int sc = pst_.mix(ev_pawns<W_>() - ev_pawns<B_>())
+          + (ev_kngts<W_>(ks[B_], at[W_]) - ev_kngts<B_>(ks[W_], at[B_])
+           + ev_bsops<W_>(ks[B_], at[W_]) - ev_bsops<B_>(ks[W_], at[B_])
+           + ev_rooks<W_>(ks[B_], at[W_]) - ev_rooks<B_>(ks[W_], at[B_])
+           + ev_qeens<W_>(ks[B_], at[W_]) - ev_qeens<B_>(ks[W_], at[B_])) / 4;
     // clang-format on
 
+    const Record& r = hist_.back();
+    r.atck          = { at[B_], at[W_] };
+    r.known |= (Record::ATCK << B_) | (Record::ATCK << W_);
+
     // knight/bishop adjustment
     // sc += (pst_.cnt(WP) + pst_.cnt(BP)) * (pst_.cnt(WN) - pst_.cnt(BN));
     // sc += (6 - qtr) * (bool(pst_.cnt(WB) > 1) - bool(pst_.cnt(BB) > 1));
@@ -336,62 +339,39 @@ namespace core {
 
   /// iGenerator ///
 
-  void Pos::esc(MoveList& l) const {
+  HOT void Pos::esc(MoveList& l) const {
 
-    auto s    = side();
-    auto f    = king_sq(s);
-    auto atck = atck_to(f, !s);
+    auto s = side();
+    auto f = king_sq(s);
+    auto p = pins();
 
-    for (auto t : u64(K_MASK[f] & ~own()))
+    for (auto t : legal(f, p))
       l.emplace_back(f, t);
 
-    if (atck.count() > 1) // king move (cause double check)
+    if (!p.target) // king move (cause double check)
       return;
 
-    auto fr   = atck.bti();
-    auto dest = db::between(fr, f) | atck;
-
-    if (ep() && (pawn(!s) & dest) && (dest & (bit(s ? ep() - 8 : ep() + 8))))
-      dest |= bit(ep());
-
     for (auto f : u64(own() - king(s)))
-      for (auto t : u64(moves(f) & dest))
+      for (auto t : legal(f, p))
         if ((pawns() & bit(f)) && (PROM & bit(t)))
           for (auto pp : { QUEEN, ROOK, BISHOP, KNIGHT })
             l.emplace_back(f, t, pp);
         else
           l.emplace_back(f, t);
   }
-  void Pos::gen(MoveList& l) const {
-
-    bool s = side();
-
-    for (auto f : pawn(s)) {
-      for (auto t : s ? u64((wpan_moves(f) | wpan_capts(f)) & ~PROM)
-                      : u64((bpan_moves(f) | bpan_capts(f)) & ~PROM))
-        l.emplace_back(f, t);
+  HOT void Pos::gen(MoveList& l) const {
 
-      for (auto t : s ? u64((wpan_moves(f) | wpan_capts(f)) & PROM)
-                      : u64((bpan_moves(f) | bpan_capts(f)) & PROM))
-        for (auto pp : { QUEEN, ROOK, BISHOP, KNIGHT })
-          l.emplace_back(f, t, pp);
-    }
-    for (auto f : kngt(s))
-      for (auto t : u64(N_MASK[f] & ~own()))
-        l.emplace_back(f, t);
-
-    for (auto f : u64(bsop(s) | qeen(s)))
-      for (auto t : bsop_moves(f))
-        l.emplace_back(f, t);
+    auto p = pins();
 
-    for (auto f : u64(rook(s) | qeen(s)))
-      for (auto t : rook_moves(f))
-        l.emplace_back(f, t);
-
-    for (auto t : s ? wkng_moves(king_sq(s)) : bkng_moves(king_sq(s)))
-      l.emplace_back(king_sq(s), t);
+    for (auto f : own())
+      for (auto t : legal(f, p))
+        if ((pawns() & bit(f)) && (PROM & bit(t)))
+          for (auto pp : { QUEEN, ROOK, BISHOP, KNIGHT })
+            l.emplace_back(f, t, pp);
+        else
+          l.emplace_back(f, t);
   }
-  void Pos::all(MoveList& l) const {
+  HOT void Pos::all(MoveList& l) const {
     if (check())
       esc(l);
     else
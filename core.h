@@ -21,6 +21,7 @@
 #define CORE_H
 
 #include "array_rn.h"
+#include "cpu.h"
 #include "db.h"
 #include "fen.h"
 #include "hash.h"
@@ -59,7 +60,11 @@ namespace core {
     }
 
     uint64_t key(bool side) const {
-      return key_ ^ hash::key(EMPTY, cr()) ^ hash::key(side, ep());
+      return key(side, cr(), ep(), 0);
+    }
+    // key with other flags & pieces xor'ed in
+    uint64_t key(bool side, int cr, int ep, uint64_t pieces) const {
+      return key_ ^ pieces ^ hash::key(EMPTY, cr) ^ hash::key(side, ep);
     }
     int ep() const {
       return ep_;
@@ -107,28 +112,128 @@ namespace core {
     }
   };
 
-  class Stack : public std::vector<State> {
+  // per ply: the state & the move that led to it (+ its capture),
+  // attack data is computed on first use & kept with the ply, so
+  // an undo_move finds the parent's still valid
+  struct Record {
+    // known: ATCK << side
+    enum : uint8_t { CHECKERS = 1, ATCK = 2, SQ_ATCK = 8 };
+
+    State state;
+    Move move;
+    uint8_t cp;
+    mutable uint8_t known;
+    mutable uint8_t sq;                  // of sq_atck
+    mutable u64 checkers;                // of the side to move's king
+    mutable std::array<u64, N_CLR> atck; // by side, through the other king
+    mutable u64 sq_atck;                 // attackers of sq, both sides
+  };
+
+  // position history: one fixed array of records, no heap, the last
+  // one is the current state. plies before the first record (fen
+  // move number, dropped @compact) are counted only
+  class History {
    public:
-    Stack() {
-      reserve(1024);
+    static constexpr int N    = 1024;
+    static constexpr int KEEP = 2 * MAX_DEPTH; // a search undoes less
+
+    History() {
       reset();
     }
+    // a clone gets the records the repetition test can reach
+    History(const History& o) {
+      *this = o;
+    }
+    History& operator=(const History& o) {
+      int n = std::min(o.size_, o.back().state.r50() + 1);
+      std::copy(o.r_ + o.size_ - n, o.r_ + o.size_, r_);
+      size_      = n;
+      ply0_      = o.ply0_ + o.size_ - n;
+      r_[0].move = Move::none();
+      return *this;
+    }
     // copy state @do_move
-    void rem() {
-      push_back(back());
+    void rem(Move m = Move::none(), int cp = EMPTY) {
+      if (size_ == N) [[unlikely]]
+        compact();
+      Record& r = r_[size_++];
+      r.state   = r_[size_ - 2].state;
+      r.move    = m;
+      r.cp      = cp;
+      r.known   = 0;
     }
     // trash it @undo_move
     void res() {
-      pop_back();
+      size_--;
+    }
+    // null move: same board, the attack maps stay valid
+    void keep_atck() {
+      Record& r       = back();
+      const Record& o = r_[size_ - 2];
+      r.atck          = o.atck;
+      r.sq            = o.sq;
+      r.sq_atck       = o.sq_atck;
+      r.known         = o.known & ~Record::CHECKERS;
     }
     void reset() {
-      clear();
-      emplace_back(State());
+      r_[0] = { State(), Move::none(), EMPTY, 0, 0, 0, { 0, 0 }, 0 };
+      size_ = 1;
+      ply0_ = 0;
+    }
+    // plies without a record (fen move number)
+    void skip(int n) {
+      ply0_ += n;
+    }
+    int ply() const {
+      return ply0_ + size_;
+    }
+    // no move record left: nothing to undo
+    bool empty() const {
+      return back().move == Move::none();
+    }
+    const Record& back() const {
+      return r_[size_ - 1];
+    }
+    Record& back() {
+      return r_[size_ - 1];
     }
     bool is_repetition() const;
     uint64_t key() const {
-      return back().key(size() & 1);
+      return back().state.key(ply() & 1);
     }
+
+   private:
+    int size_ = 0;
+    int ply0_ = 0;
+    union {
+      Record r_[N];
+    };
+
+    // full (a very long game): keep the last KEEP or r50 + 1
+    [[gnu::cold, gnu::noinline]] void compact() {
+      int n = std::max(KEEP, back().state.r50() + 1);
+      std::copy(r_ + size_ - n, r_ + size_, r_);
+      ply0_ += size_ - n;
+      size_      = n;
+      r_[0].move = Move::none();
+    }
+  };
+
+  // pinned pieces of the side to move & the squares a non-king
+  // move has to reach: all, or in check the checker & the squares
+  // between, none @double check
+  struct Pins {
+    u64 pinned;
+    u64 target;
+  };
+  // once per node: the side to move's pins, the squares its pieces
+  // give check from (by piece type) & its pieces whose move may
+  // uncover a check on the opponent's king @ksq
+  struct CheckInfo {
+    Pins pins;
+    std::array<u64, N_PIECES> squares;
+    u64 blockers;
+    int ksq;
   };
 
   class Pos {
@@ -137,6 +242,11 @@ namespace core {
     Pos(const std::string& fen = fen::new_game) {
       set(fen);
     }
+    // copies (clones for other threads) take the board & the history
+    // records a repetition can reach, not the whole game
+    Pos(const Pos&)            = default;
+    Pos& operator=(const Pos&) = default;
+
     void set(const std::string& fen);
 
     void flip();
@@ -151,7 +261,49 @@ namespace core {
       return ply() & 0x1;
     }
     bool check() const {
-      return batck_to(king_sq(side()), !side());
+      const Record& r = hist_.back();
+      if (r.known & (Record::ATCK << !side())) {
+        db::count(db::lookups.replaced, 2);
+        return r.atck[!side()] & king(side());
+      }
+      return checkers();
+    }
+    // attackers of the side to move's king, once per position
+    u64 checkers() const {
+      const Record& r = hist_.back();
+      if (r.known & Record::CHECKERS) {
+        db::count(db::lookups.replaced, 2);
+        return r.checkers;
+      }
+      r.known |= Record::CHECKERS;
+      return r.checkers = atck_to(king_sq(side()), !side());
+    }
+    // attackers of sq by both sides, kept for one square per position:
+    // the captures of a node mostly target the same few squares
+    u64 sq_attackers(int sq) const {
+      const Record& r = hist_.back();
+      if ((r.known & Record::SQ_ATCK) && r.sq == sq) {
+        db::count(db::lookups.replaced, 2);
+        return r.sq_atck;
+      }
+      r.known |= Record::SQ_ATCK;
+      r.sq = sq;
+      return r.sq_atck = atck_to(sq);
+    }
+    // squares side S attacks, its sliders see through the other king
+    // (where that king may go), once per position or filled by eval
+    u64 attacks(bool S) const {
+      const Record& r = hist_.back();
+      if (!(r.known & (Record::ATCK << S))) {
+        r.known |= Record::ATCK << S;
+        r.atck[S] = attack_map(S);
+      }
+      return r.atck[S];
+    }
+    // any of sqs attacked by side, an atck_to per square before
+    bool attacked(u64 sqs, bool side) const {
+      db::count(db::lookups.replaced, 2 * sqs.count());
+      return attacks(side) & sqs;
     }
     bool in_check() const { // note: side-flip
       return batck_to(king_sq(!side()), side());
@@ -167,7 +319,7 @@ namespace core {
       return state().cr();
     }
     int ply() const {
-      return undo_stack.size();
+      return hist_.ply();
     }
     int pc(int sq) const {
       return piece(sq) >> 1;
@@ -234,7 +386,50 @@ namespace core {
       return K_MASK[king_sq(side)];
     }
     uint64_t key() const {
-      return undo_stack.key();
+      return hist_.key();
+    }
+    // key after do_move(m), the move isn't made (tt prefetch)
+    uint64_t key_after(Move m) const {
+      const int fr = m.fr();
+      const int to = m.to();
+      const int cp = piece(to);
+      const int p  = piece(fr);
+
+      uint64_t k = hash::move_key(p, fr, to);
+      int ep     = 0;
+
+      if (cp)
+        k ^= hash::key(cp, to);
+
+      if (p == WK) {
+        if (m.is(388))
+          k ^= hash::move_key(WR, H1, F1);
+        else if (m.is(132))
+          k ^= hash::move_key(WR, A1, D1);
+      } else if (p == WP) {
+        if (to - fr == 16)
+          ep = fr + 8;
+        else if (to == this->ep())
+          k ^= hash::key(BP, to - 8);
+        else if (to > 55)
+          k ^= hash::key(WP, to) ^ hash::key((m.pp() << 1) + 1, to);
+      } else if (p == BK) {
+        if (m.is(4028))
+          k ^= hash::move_key(BR, H8, F8);
+        else if (m.is(3772))
+          k ^= hash::move_key(BR, A8, D8);
+      } else if (p == BP) {
+        if (fr - to == 16)
+          ep = to + 8;
+        else if (this->ep() && to == this->ep())
+          k ^= hash::key(WP, to + 8);
+        else if (to < 8)
+          k ^= hash::key(BP, to) ^ hash::key(m.pp() << 1, to);
+      }
+      return state().key(!side(), cr() & CR[fr] & CR[to], ep, k);
+    }
+    uint64_t key_after_null() const {
+      return state().key(!side(), cr(), 0, 0);
     }
 
     /// raw-generator ///
@@ -276,11 +471,10 @@ namespace core {
 
       u64 to = 0;
       // add OOO if legal
-      if (!(QR & occ()) && cr(W_OOO) && !atck_to(sq, B_)
-          && !atck_to(sq - 1, B_))
+      if (!(QR & occ()) && cr(W_OOO) && !attacked(bit(sq) | bit(sq - 1), B_))
         to |= TQ;
       // add OO if legal
-      if (!(KR & occ()) && cr(W_OO) && !atck_to(sq, B_) && !atck_to(sq + 1, B_))
+      if (!(KR & occ()) && cr(W_OO) && !attacked(bit(sq) | bit(sq + 1), B_))
         to |= TK;
 
       return (K_MASK[sq] & ~(own())) | to;
@@ -293,11 +487,10 @@ namespace core {
 
       u64 to = 0;
       // add OOO if legal
-      if (!(QR & occ()) && cr(B_OOO) && !atck_to(sq, W_)
-          && !atck_to(sq - 1, W_))
+      if (!(QR & occ()) && cr(B_OOO) && !attacked(bit(sq) | bit(sq - 1), W_))
         to |= TQ;
       // add OO if legal
-      if (!(KR & occ()) && cr(B_OO) && !atck_to(sq, W_) && !atck_to(sq + 1, W_))
+      if (!(KR & occ()) && cr(B_OO) && !attacked(bit(sq) | bit(sq + 1), W_))
         to |= TK;
 
       return (K_MASK[sq] & ~(own())) | to;
@@ -331,16 +524,33 @@ namespace core {
       return S ? WP_ATCK[sq] : BP_ATCK[sq];
     }
     u64 bsop_atck(int sq) const {
-      u64 sig = (occ() ^ king(!color(sq))) & db::sig_bsop(sq);
-      return db::magic_bsop(sq, sig * B_MAGIC[sq] >> 55);
+      u64 sig = db::index_bsop(sq, occ() ^ king(!color(sq)));
+      return db::magic_bsop(sq, sig);
     }
     u64 rook_atck(int sq) const {
-      u64 sig = (occ() ^ king(!color(sq))) & db::sig_rook(sq);
-      return db::magic_rook(sq, sig * R_MAGIC[sq] >> 52);
+      u64 sig = db::index_rook(sq, occ() ^ king(!color(sq)));
+      return db::magic_rook(sq, sig);
     }
     u64 qeen_atck(int sq) const {
       return rook_atck(sq) | bsop_atck(sq);
     }
+    template <bool S>
+    u64 pawn_atcks() const {
+      u64 p = pawn(S);
+      return S ? ((p & db::CLEAR_A) << 7) | ((p & db::CLEAR_H) << 9)
+               : ((p & db::CLEAR_A) >> 9) | ((p & db::CLEAR_H) >> 7);
+    }
+    u64 attack_map(bool S) const {
+      u64 a = (S ? pawn_atcks<W_>() : pawn_atcks<B_>()) | kingspace(S);
+
+      for (auto sq : kngt(S))
+        a |= N_MASK[sq];
+      for (auto sq : u64(bsop(S) | qeen(S)))
+        a |= bsop_atck(sq);
+      for (auto sq : u64(rook(S) | qeen(S)))
+        a |= rook_atck(sq);
+      return a;
+    }
     u64 atck_to(int sq, int side) const {
       u64 attacker = 0;
 
@@ -352,6 +562,19 @@ namespace core {
 
       return attacker;
     }
+    // both sides, each pawn by its own direction
+    u64 atck_to(int sq) const {
+      u64 attacker = 0;
+
+      attacker |= pawn(W_) & db::att_by_pawn(sq, W_);
+      attacker |= pawn(B_) & db::att_by_pawn(sq, B_);
+      attacker |= kngts() & N_MASK[sq];
+      attacker |= bsops() & db::magic_bsop(sq, magic_b(sq));
+      attacker |= rooks() & db::magic_rook(sq, magic_r(sq));
+      attacker |= kings() & K_MASK[sq];
+
+      return attacker;
+    }
     u64 all_atck_to(int sq) const {
       u64 attacker = 0;
 
@@ -397,24 +620,163 @@ namespace core {
 
       return false;
     }
+    // sliders see through occ only, e.g. w/o the moving king
+    bool batck_to(int sq, int side, u64 occ) const {
+      // clang-format off
+      return (pawn(side) & db::att_by_pawn(sq, side))
+          || (kngt(side) & N_MASK[sq])
+          || (king(side) & K_MASK[sq])
+          || ((bsop(side) | qeen(side))
+              & db::magic_bsop(sq, db::index_bsop(sq, occ)))
+          || ((rook(side) | qeen(side))
+              & db::magic_rook(sq, db::index_rook(sq, occ)));
+      // clang-format on
+    }
+
+    /// legality ///
+
+    // once per node for the side to move
+    Pins pins() const {
+      bool s  = side();
+      int ks  = king_sq(s);
+      Pins r  = { 0, ~0ULL };
+      u64 snp = ((rook(!s) | qeen(!s)) & R_MASK[ks])
+              | ((bsop(!s) | qeen(!s)) & B_MASK[ks]);
+
+      for (auto sq : snp) {
+        u64 b = db::between(ks, sq) & occ();
+        if (b.count() == 1 && (b & own()))
+          r.pinned |= b;
+      }
+      if (u64 a = checkers())
+        r.target = a.count() > 1 ? u64(0)
+                                 : u64(db::between(ks, a.bti()) | a);
+      return r;
+    }
+    CheckInfo check_info() const {
+      bool s = side();
+      int ks = king_sq(!s);
+
+      CheckInfo r;
+      r.pins            = pins();
+      r.ksq             = ks;
+      r.squares[EMPTY]  = 0;
+      r.squares[PAWN]   = db::att_by_pawn(ks, s);
+      r.squares[KNIGHT] = N_MASK[ks];
+      r.squares[BISHOP] = db::magic_bsop(ks, magic_b(ks));
+      r.squares[ROOK]   = db::magic_rook(ks, magic_r(ks));
+      r.squares[QUEEN]  = r.squares[BISHOP] | r.squares[ROOK];
+      r.squares[KING]   = 0;
+      r.blockers        = 0;
+
+      u64 snp = ((rook(s) | qeen(s)) & R_MASK[ks])
+              | ((bsop(s) | qeen(s)) & B_MASK[ks]);
+
+      for (auto sq : snp) {
+        u64 b = db::between(ks, sq) & occ();
+        if (b.count() == 1 && (b & own()))
+          r.blockers |= b;
+      }
+      return r;
+    }
+    // O(1) but for promotions, ep & castling
+    bool gives_check(Move m, const CheckInfo& ci) const {
+      const int fr = m.fr();
+      const int to = m.to();
+      const int pc = this->pc(fr);
+      const bool s = side();
+
+      if (ci.squares[pc] & bit(to))
+        return true;
+      if ((ci.blockers & bit(fr)) && !(db::ray(ci.ksq, fr) & bit(to)))
+        return true;
+
+      u64 o = occ() ^ bit(fr);
+      if (m.pp()) {
+        if (m.pp() == KNIGHT)
+          return N_MASK[to] & bit(ci.ksq);
+        u64 a = 0;
+        if (m.pp() != ROOK)
+          a |= db::magic_bsop(to, db::index_bsop(to, o));
+        if (m.pp() != BISHOP)
+          a |= db::magic_rook(to, db::index_rook(to, o));
+        return a & bit(ci.ksq);
+      }
+      if (pc == PAWN && ep() && to == ep()) {
+        o = (o ^ bit(s ? to - 8 : to + 8)) | bit(to);
+        return ((bsop(s) | qeen(s))
+                & db::magic_bsop(ci.ksq, db::index_bsop(ci.ksq, o)))
+            || ((rook(s) | qeen(s))
+                & db::magic_rook(ci.ksq, db::index_rook(ci.ksq, o)));
+      }
+      if (pc == KING && std::abs(to - fr) == 2) {
+        int rfr = to > fr ? fr + 3 : fr - 4;
+        int rto = (fr + to) >> 1;
+        o       = (o ^ bit(rfr)) | bit(to) | bit(rto);
+        return db::magic_rook(rto, db::index_rook(rto, o)) & bit(ci.ksq);
+      }
+      return false;
+    }
+    // legal destinations of the own piece @sq
+    u64 legal(int sq, const Pins& p) const {
+      bool s = side();
+      int ks = king_sq(s);
+      u64 to = moves(sq);
+
+      if (sq == ks) {
+        db::count(db::lookups.replaced, 2 * to.count());
+        return to & ~attacks(!s);
+      }
+      if (p.pinned & bit(sq))
+        to &= db::ray(ks, sq);
+
+      // ep: the captured pawn may be the checker, both pawns
+      // may leave the king's rank
+      if (ep() && (to & bit(ep())) && (pawn(s) & bit(sq))) {
+        int cp  = s ? ep() - 8 : ep() + 8;
+        u64 o   = (occ() ^ bit(sq) ^ bit(cp)) | bit(ep());
+        bool ok = (p.target & (bit(cp) | bit(ep())))
+               && !((bsop(!s) | qeen(!s))
+                    & db::magic_bsop(ks, db::index_bsop(ks, o)))
+               && !((rook(!s) | qeen(!s))
+                    & db::magic_rook(ks, db::index_rook(ks, o)));
+        return (to & p.target & ~bit(ep())) | (ok ? bit(ep()) : u64(0));
+      }
+      return to & p.target;
+    }
 
     /// do/undo move ///
 
+    // the mover's side @compile time: S == side()
     bool do_move(Move m) {
+      return side() ? make<W_, false>(m) : make<B_, false>(m);
+    }
+    // m from a legal generator: no in_check test
+    void do_legal(Move m) {
+      side() ? make<W_, true>(m) : make<B_, true>(m);
+    }
+    template <bool S>
+    void do_legal(Move m) {
+      make<S, true>(m);
+    }
+    template <bool S, bool LEGAL>
+    bool make(Move m) {
+      constexpr int P  = S ? WP : BP;
+      constexpr int K  = S ? WK : BK;
+      constexpr int R  = S ? WR : BR;
+      constexpr int UP = S ? 8 : -8;
+
       const int fr = m.fr();
       const int to = m.to();
       const int ep = state().ep();
       const int cp = piece(to);
       const int p  = piece(fr);
 
-      assert(p >= BP && p <= WK);
+      assert(p >= BP && p <= WK && (p & 1) == S);
       assert(fr >= A1 && fr <= H8);
       assert(to >= A1 && to <= H8);
 
-      undo_stack.rem();
-
-      move_stack_.push_back(m);
-      cp_stack_.push_back(cp);
+      hist_.rem(m, cp);
 
       if (cp) {
         clear_sq(to);
@@ -424,59 +786,30 @@ namespace core {
 
       state().clear_ep();
 
-      if (p & 1) {
-
-        if (p == WK) {
-          if (m.is(388)) {
-            assert(m.is_00());
-            move(WR, H1, F1);
-          } else if (m.is(132)) {
-            assert(m.is_00());
-            move(WR, A1, D1);
-          }
-        } else if (p == WP) {
-          if (to - fr == 16)
-            state().set_ep(fr + 8);
-          else if (to == ep)
-            clear_sq(ep - 8);
-          else if (to > 55) {
-            assert(m.pp() >= KNIGHT && m.pp() <= QUEEN);
-            clear_sq(to);
-            set_sq((m.pp() << 1) + 1, to);
-          }
-          state().clear_r50();
-        } else if (cp == EMPTY)
-          state().next_r50();
-        else
-          state().clear_r50();
-      } else {
-        if (p == BK) {
-          if (m.is(4028)) {
-            assert(m.is_00());
-            move(BR, H8, F8);
-          } else if (m.is(3772)) {
-            assert(m.is_00());
-            move(BR, A8, D8);
-          }
-        } else if (p == BP) {
-          if (fr - to == 16)
-            state().set_ep(to + 8);
-          else if (ep && to == ep)
-            clear_sq(ep + 8);
-          else if (to < 8) {
-            assert(m.pp() >= KNIGHT && m.pp() <= QUEEN);
-            clear_sq(to);
-            set_sq(m.pp() << 1, to);
-          }
-          state().clear_r50();
-        } else if (cp == EMPTY)
-          state().next_r50();
-        else
-          state().clear_r50();
-      }
-
-      if (in_check()) {
-        undo_move();
+      if (p == K) {
+        // castling: the king moves 2, the rook jumps over it
+        if (to - fr == 2 || fr - to == 2) {
+          assert(m.is_00());
+          move(R, to > fr ? to + 1 : to - 2, (fr + to) / 2);
+        }
+      } else if (p == P) {
+        if (to - fr == 2 * UP)
+          state().set_ep(fr + UP);
+        else if (ep && to == ep)
+          clear_sq(ep - UP);
+        else if (m.pp()) {
+          assert(m.pp() >= KNIGHT && m.pp() <= QUEEN);
+          clear_sq(to);
+          set_sq((m.pp() << 1) + S, to);
+        }
+        state().clear_r50();
+      } else if (cp == EMPTY)
+        state().next_r50();
+      else
+        state().clear_r50();
+
+      if (!LEGAL && batck_to(king_sq(S), !S)) {
+        undo_move<S>();
         return false;
       }
 
@@ -484,14 +817,22 @@ namespace core {
       return true;
     }
     void undo_move() {
-      if (move_stack_.empty())
+      if (hist_.empty())
         return;
+      // side() still is the opponent's
+      side() ? undo_move<B_>() : undo_move<W_>();
+    }
+    template <bool S>
+    void undo_move() {
+      constexpr int P   = S ? WP : BP;
+      constexpr int K   = S ? WK : BK;
+      constexpr int R   = S ? WR : BR;
+      constexpr int OPP = S ? BP : WP;
+      constexpr int UP  = S ? 8 : -8;
 
-      Move m = move_stack_.back();
-      move_stack_.pop_back();
-      int cp = cp_stack_.back();
-      cp_stack_.pop_back();
-      undo_stack.res();
+      Move m = hist_.back().move;
+      int cp = hist_.back().cp;
+      hist_.res();
 
       int to = m.to();
       int fr = m.fr();
@@ -504,107 +845,80 @@ namespace core {
         rset_sq(cp, to);
       }
 
-      if (side()) {
-        if (p == WK) {
-          if (m.is(388)) {
-            assert(m.is_00());
-            rmove(WR, F1, H1);
-          } else if (m.is(132)) {
-            assert(m.is_00());
-            rmove(WR, D1, A1);
-          }
-        } else if (p == WP && to == ep) {
-          rset_sq(BP, ep - 8);
-        } else if (m.pp()) {
-          rclear_sq(fr);
-          rset_sq(WP, fr);
-        }
-      } else {
-        if (p == BK) {
-          if (m.is(4028)) {
-            assert(m.is_00());
-            rmove(BR, F8, H8);
-          } else if (m.is(3772)) {
-            assert(m.is_00());
-            rmove(BR, D8, A8);
-          }
-        } else if (p == BP && to == ep) {
-          rset_sq(WP, ep + 8);
-        }
-
-        else if (m.pp()) {
-          rclear_sq(fr);
-          rset_sq(BP, fr);
-        }
+      if (p == K) {
+        if (to - fr == 2 || fr - to == 2)
+          rmove(R, (fr + to) / 2, to > fr ? to + 1 : to - 2);
+      } else if (p == P) {
+        if (ep && to == ep)
+          rset_sq(OPP, ep - UP);
+      } else if (m.pp()) {
+        rclear_sq(fr);
+        rset_sq(P, fr);
       }
     }
     void do_null() {
-      undo_stack.rem();
+      hist_.rem();
+      hist_.keep_atck();
       state().clear_ep();
     }
     void undo_null() {
-      undo_stack.res();
+      hist_.res();
     }
 
     /// eval ///
 
-    int lva(int sq) {
-
-      u64 a = 0;
-
-      if ((a |= (pawn(side())) & db::att_by_pawn(sq, side())))
-        return a.lsbi();
-      if ((a |= (kngt(side())) & N_MASK[sq]))
-        return a.lsbi();
-
-      auto b = (occ() & db::sig_bsop(sq)) * B_MAGIC[sq] >> 55;
-
-      if ((a |= (bsop(side()) & db::magic_bsop(sq, b))))
-        return a.lsbi();
-
-      auto r = (occ() & db::sig_rook(sq)) * R_MAGIC[sq] >> 52;
-
-      if ((a |= (rook(side()) & db::magic_rook(sq, r))))
-        return a.lsbi();
-
-      auto mbr = db::magic_rook(sq, r) | db::magic_bsop(sq, b);
-
-      if ((a |= (qeen(side()) & mbr)))
-        return a.lsbi();
-      if ((a |= (king(side()) & K_MASK[sq])))
-        return a.lsbi();
-
+    // the side to move's least valuable of the attackers a
+    int lva(u64 a) const {
+      bool s = side();
+      for (u64 x : { pawn(s), kngt(s), bsop(s), rook(s), qeen(s), king(s) })
+        if (x & a)
+          return u64(x & a).lsbi();
       return 64;
     }
+    // the attackers of m.to() come from the position's record,
+    // each exchange step only adds the sliders behind the mover
     int see(Move m) {
+      return see(m, sq_attackers(m.to()));
+    }
+    int see(Move m, u64 a) {
 
       int fr = m.fr();
       int to = m.to();
       int r  = VAL[piece(to)];
+      bool e = pc(fr) == PAWN && to == ep();
 
       if (!do_move(m))
         return 0;
 
-      if ((fr = lva(to)) != 64) {
+      // ep: the captured pawn left a square next to to
+      a &= ~bit(fr);
+      if (e)
+        a = atck_to(to);
+      else if (db::diagonal(to, fr))
+        a |= bsops() & db::magic_bsop(to, magic_b(to));
+      else if (db::aligned(to, fr))
+        a |= rooks() & db::magic_rook(to, magic_r(to));
+
+      if ((fr = lva(a)) != 64) {
         assert(fr >= 0 && fr < 64);
         m = (pc(fr) == PAWN && (bit(to) & PROM)) ? Move(fr, to, QUEEN)
                                                  : Move(fr, to);
-        r -= std::max(see(m), 0);
+        r -= std::max(see(m, a), 0);
       }
       undo_move();
       return r;
     }
 
     template <bool S>
-    int ev_pawns() const;
+    pst::score_t ev_pawns() const;
     template <bool S>
-    int ev_kngts(u64 kingspace);
+    int ev_kngts(u64 kingspace, u64& atck);
     template <bool S>
-    int ev_bsops(u64 kingspace);
+    int ev_bsops(u64 kingspace, u64& atck);
     template <bool S>
-    int ev_rooks(u64 kingspace);
+    int ev_rooks(u64 kingspace, u64& atck);
     template <bool S>
-    int ev_qeens(u64 kingspace);
+    int ev_qeens(u64 kingspace, u64& atck);
     template <bool S>
     int ev_kings(u64 kingspace);
     int eval();
@@ -615,7 +929,7 @@ namespace core {
       return is_repetition();
     }
     bool is_repetition() const {
-      return undo_stack.is_repetition();
+      return hist_.is_repetition();
     }
     bool null_ok() const {
       return pst_.null_ok(side());
@@ -624,13 +938,21 @@ namespace core {
       return (pc(m.fr()) == PAWN) && (m.to() & PUSH);
     }
     bool recap(Move m) const {
-      return m.to() == move_stack_.back().to() && cp_stack_.back();
+      return m.to() == hist_.back().move.to() && hist_.back().cp;
     }
     bool is_tactical(Move m) const {
       return m.pp() || pc(m.to()) || (pc(m.fr()) == PAWN && m.to() == ep());
     }
+    // tt & killer moves may stem from another position
+    bool is_legal(Move m, const Pins& p) const {
+      if (!(own() & bit(m.fr())) || !(legal(m.fr(), p) & bit(m.to())))
+        return false;
+      if (pc(m.fr()) == PAWN && (bit(m.to()) & PROM))
+        return m.pp() >= KNIGHT && m.pp() <= QUEEN;
+      return !m.pp();
+    }
     Move last_move() const {
-      return move_stack_.back();
+      return hist_.back().move;
     }
 
     /// iGenerator ///
@@ -639,12 +961,8 @@ namespace core {
     void all(MoveList& l) const;
 
    private:
-    // state stack
-    Stack undo_stack;
-    // move stack
-    std::vector<Move> move_stack_;
-    // capture stack
-    std::vector<uint8_t> cp_stack_;
+    // states, moves & captures
+    History hist_;
     // piecees @ squares
     std::array<uint8_t, 64> sqrs_;
     // bb for uncolored piece types
@@ -655,10 +973,10 @@ namespace core {
     pst::Table pst_;
 
     const State& state() const {
-      return undo_stack.back();
+      return hist_.back().state;
     }
     State& state() {
-      return undo_stack.back();
+      return hist_.back().state;
     }
 
     // do_move: update state-copy
@@ -725,16 +1043,16 @@ namespace core {
     }
 
     u64 magic_r(int sq) const {
-      return (occ() & db::sig_rook(sq)) * R_MAGIC[sq] >> 52;
+      return db::index_rook(sq, occ());
     }
     u64 magic_b(int sq) const {
-      return (occ() & db::sig_bsop(sq)) * B_MAGIC[sq] >> 55;
+      return db::index_bsop(sq, occ());
     }
     u64 magic_r(int sq, u64 exclude) const {
-      return (occ() & ~exclude & db::sig_rook(sq)) * R_MAGIC[sq] >> 52;
+      return db::index_rook(sq, occ() & ~exclude);
     }
     u64 magic_b(int sq, u64 exclude) const {
-      return (occ() & ~exclude & db::sig_bsop(sq)) * B_MAGIC[sq] >> 55;
+      return db::index_bsop(sq, occ() & ~exclude);
     }
   };
 
@@ -0,0 +1,57 @@
+/*---------------------------------------------------------------------
+
+  Bienchen - UCI chess engine
+  © 2022 Manuel Schenske
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+---------------------------------------------------------------------*/
+
+#ifndef CPU_H
+#define CPU_H
+
+// one binary for every x86-64: the hot kernels (eval, move generation,
+// search, perft) are compiled once per instruction set, the loader
+// picks the best clone (ifunc). bits.h, db.h & pst.h inline into them.
+// bmi2: x86-64-v3 (avx2, bmi1/2, popcnt, lzcnt), gcc only
+#if defined(__x86_64__) && defined(__ELF__)
+#if defined(__clang__)
+#define HOT __attribute__((target_clones("avx2", "popcnt", "default")))
+#else
+#define HOT                                                                    \
+  __attribute__((target_clones("arch=x86-64-v3", "avx2", "popcnt", "default")))
+#endif
+#else
+#define HOT
+#endif
+
+namespace cpu {
+
+  // the clone the loader has chosen, same order as HOT
+  inline const char* path() {
+#if defined(__x86_64__) && defined(__ELF__)
+    __builtin_cpu_init();
+#if !defined(__clang__)
+    if (__builtin_cpu_supports("x86-64-v3"))
+      return "bmi2";
+#endif
+    if (__builtin_cpu_supports("avx2"))
+      return "avx2";
+    if (__builtin_cpu_supports("popcnt"))
+      return "popcnt";
+#endif
+    return "generic";
+  }
+} // namespace cpu
+
+#endif
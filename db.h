@@ -22,15 +22,24 @@
 
 #include "array_rn.h"
 #include "main.h"
+#include "mem.h"
+
+#include <type_traits>
+
+#ifdef USE_PEXT
+#include <immintrin.h>
+#endif
 
 namespace db {
 
   /// lookup's
+  // hot path footprint (do/undo_move, eval, gen):
+  //   hash::psKey 7 KB, pst::square_pst 3.5 KB,
+  //   distance_ 4 KB, ray_ + dir_ 8.5 KB, att_by_pawn_ etc. 1-2 KB each,
+  //   slider tables bsop_atck_ 41 KB & rook_atck_ 800 KB
   typedef array_rn<u64, N_SQ> R_U;
   typedef array_rn<u64, N_CLR, N_SQ> R_2U;
-  typedef array_rn<u64, N_SQ, N_SQ> R_UU;
-  typedef array_rn<u64, N_SQ, 512> b_magic_t;
-  typedef array_rn<u64, N_SQ, 4096> r_magic_t;
+  typedef array_rn<uint8_t, N_SQ, N_SQ> R_88;
 
   enum { B, R };
 
@@ -46,7 +55,7 @@ namespace db {
 
   /// distance ///////////////////////////
 
-  static consteval R_UU make_distance() {
+  static consteval R_88 make_distance() {
 
     auto dist = [](int s1, int s2) {
       int file_1 = s1 & 7;
@@ -57,14 +66,14 @@ namespace db {
       return std::max(my_abs(file_1 - file_2), my_abs(rank_1 - rank_2));
     };
 
-    R_UU r;
+    R_88 r;
     for (auto s1 : UNIVERSE)
       for (auto s2 : UNIVERSE)
         r[s1][s2] = dist(s1, s2);
 
     return r;
   }
-  static constexpr R_UU distance_ = make_distance();
+  inline constexpr R_88 distance_ = make_distance();
 
   /// king_def ///////////////////////////
 
@@ -78,45 +87,47 @@ namespace db {
     }
     return r;
   }
-  static constexpr R_U king_def_space_ = make_king_def_space();
+  inline constexpr R_U king_def_space_ = make_king_def_space();
 
   /// between ////////////////////////////
 
-  static constexpr u64 bb_between(u64 u) {
-    if (u.count() != 2)
-      return 0x0;
-
-    int hi = u.lsbi();
-    int lo = u.msbi();
-
-    int fhi = hi & 7;
-    int flo = lo & 7;
-    int rhi = hi >> 3;
-    int rlo = lo >> 3;
-
-    u64 R = (R_MASK[hi] & R_MASK[lo]);
-    u64 B = (B_MASK[hi] & B_MASK[lo]);
-
-    u64 U = ~1ULL << lo;
-    u64 L = (1ULL << hi) - 1;
-
-    if (fhi == flo || rhi == rlo)
-      return ~(U | L) & R;
-    else if (my_abs(hi - lo) % 7 == 0 || my_abs(hi - lo) % 9 == 0)
-      return ~(U | L) & B;
-
-    return 0;
+  // 8 rays per square + a direction per square pair: 8.5 KB
+  // instead of a 32 KB 64 x 64 table
+  enum { N_DIR = 8, NO_DIR = N_DIR };
+  static constexpr int DIR_STEP[N_DIR][2] = {
+    { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 },
+    { 1, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 }
+  };
+
+  static consteval array_rn<u64, N_DIR + 1, N_SQ> make_ray() {
+
+    array_rn<u64, N_DIR + 1, N_SQ> r{};
+    for (int d = 0; d < N_DIR; d++)
+      for (int sq = A1; sq <= H8; sq++) {
+        int f = (sq & 7) + DIR_STEP[d][0];
+        int k = (sq >> 3) + DIR_STEP[d][1];
+
+        for (; f >= 0 && f < 8 && k >= 0 && k < 8;
+             f += DIR_STEP[d][0], k += DIR_STEP[d][1])
+          r[d][sq] |= bit(f + 8 * k);
+      }
+    return r;
   }
-  static constexpr R_UU make_between() {
+  inline constexpr array_rn<u64, N_DIR + 1, N_SQ> ray_ = make_ray();
 
-    R_UU r;
-    for (auto x : UNIVERSE)
-      for (auto y : UNIVERSE)
-        r[x][y] = bb_between((1ULL << x) | (1ULL << y));
+  static consteval R_88 make_dir() {
 
+    R_88 r;
+    for (int x = A1; x <= H8; x++)
+      for (int y = A1; y <= H8; y++) {
+        r[x][y] = NO_DIR;
+        for (int d = 0; d < N_DIR; d++)
+          if (ray_[d][x] & bit(y))
+            r[x][y] = d;
+      }
     return r;
   }
-  static constexpr R_UU between_ = make_between();
+  inline constexpr R_88 dir_ = make_dir();
 
   /// magic's ///////////////////////////
 
@@ -212,15 +223,60 @@ namespace db {
     }
     return r;
   }
-  static constexpr R_2U sig_mask_ = make_sig_mask();
+  inline constexpr R_2U sig_mask_ = make_sig_mask();
+
+  // attack tables: one block of 2^bits entries per square, packed
+  // back to back (107648 entries), indexed by the blockers on the
+  // mask: fancy magics (see magic.cpp) or USE_PEXT: _pext_u64
+  static consteval array_rn<uint32_t, 2, N_SQ + 1> make_offset() {
+
+    array_rn<uint32_t, 2, N_SQ + 1> r{};
+    for (int t : { B, R })
+      for (int sq = A1; sq <= H8; sq++)
+        r[t][sq + 1] = r[t][sq] + (1 << sig_mask_[t][sq].count());
+    return r;
+  }
+  inline constexpr array_rn<uint32_t, 2, N_SQ + 1> offset_ = make_offset();
+
+  static consteval array_rn<uint8_t, 2, N_SQ> make_shift() {
+
+    array_rn<uint8_t, 2, N_SQ> r;
+    for (int t : { B, R })
+      for (int sq = A1; sq <= H8; sq++)
+        r[t][sq] = 64 - sig_mask_[t][sq].count();
+    return r;
+  }
+  inline constexpr array_rn<uint8_t, 2, N_SQ> shift_ = make_shift();
+
+  template <int T>
+  static constexpr size_t base(int sq) {
+    return offset_[T][sq];
+  }
+  // entry of the occ-th subset of the mask, blx
+  template <int T>
+  static constexpr size_t slot(int sq, u64 blx, int occ) {
+#ifdef USE_PEXT
+    (void)blx;
+    return base<T>(sq) + occ; // == _pext_u64(blx, mask)
+#else
+    (void)occ;
+    return base<T>(sq)
+         + (blx * (T == B ? B_MAGIC[sq] : R_MAGIC[sq]) >> shift_[T][sq]);
+#endif
+  }
+
+  typedef array_rn<u64, base<B>(N_SQ)> b_magic_t;
+  typedef array_rn<u64, base<R>(N_SQ)> r_magic_t;
 
   static constexpr b_magic_t make_b() {
 
     b_magic_t r;
 
     for (auto sq : UNIVERSE) {
-      for (int occ = 0; occ < 512; ++occ) {
-        u64 att = sig_mask_[B][sq];
+      u64 att = sig_mask_[B][sq];
+
+      // each subset of the mask once
+      for (int occ = 0; occ < 1 << att.count(); ++occ) {
         u64 blx = 0;
         int i   = 0;
 
@@ -228,18 +284,17 @@ namespace db {
           if (occ & bit(i++))
             blx |= bit(s);
 
-        r[sq][blx * B_MAGIC[sq] >> 55] = gen_bishop(blx, bit(sq));
+        r[slot<B>(sq, blx, occ)] = gen_bishop(blx, bit(sq));
       }
     }
     return r;
   }
-  static constexpr r_magic_t make_r() {
-
-    r_magic_t r;
+  static constexpr void fill_r(r_magic_t& r) {
 
     for (auto sq : UNIVERSE) {
-      for (int occ = 0; occ < 4096; occ++) {
-        u64 att = sig_mask_[R][sq];
+      u64 att = sig_mask_[R][sq];
+
+      for (int occ = 0; occ < 1 << att.count(); occ++) {
         u64 blx = 0;
         int i   = 0;
 
@@ -247,13 +302,29 @@ namespace db {
           if (occ & bit(i++))
             blx |= bit(s);
 
-        r[sq][blx * R_MAGIC[sq] >> 52] = gen_rook(blx, bit(sq));
+        r[slot<R>(sq, blx, occ)] = gen_rook(blx, bit(sq));
       }
     }
-    return r;
   }
-  static const b_magic_t bsop_atck_ = make_b();
-  static const r_magic_t rook_atck_ = make_r();
+  inline constexpr b_magic_t bsop_atck_ = make_b();
+
+  // one 800 KB table for all units, padded to a huge page & filled
+  // by init(): a compile time table would live in the file backed
+  // image, no huge pages there
+  struct alignas(mem::HUGE_PAGE) r_page_t : r_magic_t {};
+  inline r_page_t rook_atck_;
+
+  // @startup: advise huge pages before the first touch
+  inline mem::Pages init(bool large) {
+    static bool filled = false;
+
+    auto pages = mem::advise(&rook_atck_, sizeof(rook_atck_), large);
+    if (!filled) {
+      fill_r(rook_atck_);
+      filled = true;
+    }
+    return pages;
+  }
 
   /// pawn's ///////////////////////////
 
@@ -295,7 +366,7 @@ namespace db {
     }
     return r;
   }
-  static constexpr R_2U passed_ = make_passed();
+  inline constexpr R_2U passed_ = make_passed();
 
   static consteval R_U make_isolated() {
 
@@ -349,21 +420,48 @@ namespace db {
     return r;
   }
 
-  static constexpr R_2U att_by_pawn_  = make_att_by_pawn();
-  static constexpr R_U isolated_      = make_isolated();
-  static constexpr R_2U forward_rank_ = make_forward_rank();
-  static constexpr R_2U forward_file_ = make_forward_file();
+  inline constexpr R_2U att_by_pawn_  = make_att_by_pawn();
+  inline constexpr R_U isolated_      = make_isolated();
+  inline constexpr R_2U forward_rank_ = make_forward_rank();
+  inline constexpr R_2U forward_file_ = make_forward_file();
 
   /// get /////////////////////////////
 
+  // slider lookups done & the ones the reads of the attack cache
+  // of core::Pos replaced (@most: some tests stop early), make lookups
+  struct Lookups {
+    uint64_t done     = 0;
+    uint64_t replaced = 0;
+  };
+  inline Lookups lookups;
+
+  inline void count([[maybe_unused]] uint64_t& c, [[maybe_unused]] int n = 1) {
+#ifdef COUNT_LOOKUPS
+    c += n;
+#endif
+  }
+
   static constexpr int distance(int s1, int s2) {
     return distance_[s1][s2];
   }
   static constexpr u64 king_def_space(int sq) {
     return king_def_space_[sq];
   }
+  // squares strictly between two aligned squares, else 0
   static constexpr u64 between(int s1, int s2) {
-    return between_[s1][s2];
+    int d = dir_[s1][s2];
+    return ray_[d][s1] & ~ray_[d][s2] & ~bit(s2);
+  }
+  // on one line (rank, file, diagonal), on one diagonal
+  static constexpr bool aligned(int s1, int s2) {
+    return dir_[s1][s2] != NO_DIR;
+  }
+  static constexpr bool diagonal(int s1, int s2) {
+    return dir_[s1][s2] >= 4 && dir_[s1][s2] != NO_DIR;
+  }
+  // half line from s1 through s2 to the edge, else 0
+  static constexpr u64 ray(int s1, int s2) {
+    return ray_[dir_[s1][s2]][s1];
   }
   static constexpr u64 att_by_pawn(int sq, bool s) {
     return att_by_pawn_[s][sq];
@@ -374,11 +472,29 @@ namespace db {
   static constexpr u64 sig_rook(int sq) {
     return sig_mask_[R][sq];
   }
+  // signature of the blockers in occ
+  inline u64 index_bsop(int sq, u64 occ) {
+#ifdef USE_PEXT
+    return _pext_u64(occ, sig_mask_[B][sq]);
+#else
+    return (occ & sig_mask_[B][sq]) * B_MAGIC[sq] >> shift_[B][sq];
+#endif
+  }
+  inline u64 index_rook(int sq, u64 occ) {
+#ifdef USE_PEXT
+    return _pext_u64(occ, sig_mask_[R][sq]);
+#else
+    return (occ & sig_mask_[R][sq]) * R_MAGIC[sq] >> shift_[R][sq];
+#endif
+  }
   static constexpr u64 magic_bsop(int sq, int sig) {
-    return bsop_atck_[sq][sig];
+    if (!std::is_constant_evaluated())
+      count(lookups.done);
+    return bsop_atck_[base<B>(sq) + sig];
   }
-  static constexpr u64 magic_rook(int sq, int sig) {
-    return rook_atck_[sq][sig];
+  inline u64 magic_rook(int sq, int sig) {
+    count(lookups.done);
+    return rook_atck_[base<R>(sq) + sig];
   }
   static constexpr u64 passed(int sq, int s) {
     return passed_[s][sq];
@@ -37,7 +37,7 @@ namespace fen {
     return (rank.find(s[1]) << 3) + (file.find(s[0]) & 7);
   }
   // fen index to internal (upside-down flip)
-  inline int index(const int i) {
+  constexpr int index(const int i) {
     return i ^ 0b111000;
   }
   // fen-piece to internal
@@ -25,68 +25,39 @@ namespace gen {
     bool s = pos.side();
     u64 p  = pos.pawn(s);
 
-    p &= s ? RANK_MASK[6] : RANK_MASK[1];
-
-    for (auto sq : p)
-      proms_[sq] = moves_[sq];
+    proms_ = p & (s ? RANK_MASK[6] : RANK_MASK[1]);
   }
-  void G::find_checks(const core::Pos& pos) {
-    bool sd = pos.side();
-    int sq  = pos.king_sq(!sd);
-
-    // pot
-    auto bsop_ckecks =
-      db::magic_bsop(sq, (pos.occ() & db::sig_bsop(sq)) * B_MAGIC[sq] >> 55)
-      & ~pos.own();
-    auto rook_ckecks =
-      db::magic_rook(sq, (pos.occ() & db::sig_rook(sq)) * R_MAGIC[sq] >> 52)
-      & ~pos.own();
-    auto kngt_ckecks = N_MASK[sq] & ~pos.own();
+  HOT void G::find_checks(const core::Pos& pos) {
+    const core::CheckInfo& ci = info(pos);
+
+    bool sd   = pos.side();
+    u64 prom  = ci.squares[KNIGHT] | ci.squares[QUEEN];
+
+    for (auto fr : pos.own()) {
+      int pc = pos.pc(fr);
+      // pawn on the 7th: promotions
+      if (pc == PAWN && ((sd && fr >= 48) || (!sd && fr <= 15)))
+        checks_[fr] = moves_[fr] & prom;
+      else
+        checks_[fr] = moves_[fr] & ci.squares[pc];
+    }
 
+    // castling, the rook checks
     if (sd) {
-      if (pos.cr(W_OOO) && (rook_ckecks & bit(D1)))
-        checks_[E1] |= bit(C1);
-      if (pos.cr(W_OO) && (rook_ckecks & bit(F1)))
-        checks_[E1] |= bit(G1);
+      if (pos.cr(W_OOO) && (ci.squares[ROOK] & bit(D1)))
+        checks_[E1] |= moves_[E1] & bit(C1);
+      if (pos.cr(W_OO) && (ci.squares[ROOK] & bit(F1)))
+        checks_[E1] |= moves_[E1] & bit(G1);
     } else {
-      if (pos.cr(B_OOO) && (rook_ckecks & bit(D8)))
-        checks_[E8] |= bit(C8);
-      if (pos.cr(B_OO) && (rook_ckecks & bit(F8)))
-        checks_[E8] |= bit(G8);
+      if (pos.cr(B_OOO) && (ci.squares[ROOK] & bit(D8)))
+        checks_[E8] |= moves_[E8] & bit(C8);
+      if (pos.cr(B_OO) && (ci.squares[ROOK] & bit(F8)))
+        checks_[E8] |= moves_[E8] & bit(G8);
     }
 
-    for (auto fr : pos.kngt(sd))
-      checks_[fr] = moves_[fr] & kngt_ckecks;
-    for (auto fr : pos.bsop(sd))
-      checks_[fr] = moves_[fr] & bsop_ckecks;
-    for (auto fr : pos.rook(sd))
-      checks_[fr] = moves_[fr] & rook_ckecks;
-    for (auto fr : pos.qeen(sd))
-      checks_[fr] = moves_[fr] & (rook_ckecks | bsop_ckecks);
-    for (auto fr : pos.pawn(sd))
-      checks_[fr] = (sd && fr < 48) || (!sd && fr > 15)
-                    ? moves_[fr] & db::att_by_pawn(sq, sd)
-                    : moves_[fr] & (rook_ckecks | bsop_ckecks | kngt_ckecks);
-
     // abzug
-    for (auto fr : u64(B_MASK[sq] & (pos.bsop(sd) | pos.qeen(sd)))) {
-      u64 my = db::between(fr, sq) & pos.own();
-      u64 op = db::between(fr, sq) & pos.opp();
-
-      if (my && !op && my.count() == 1) {
-        checks_[my.bti()] |= moves_[my.bti()] & ~db::between(fr, sq);
-        // abzug_[my.bti()] |= moves_[my.bti()] & ~db::between(fr, sq);
-      }
-    }
-    for (auto fr : u64(R_MASK[sq] & (pos.rook(sd) | pos.qeen(sd)))) {
-      u64 my = db::between(fr, sq) & pos.own();
-      u64 op = db::between(fr, sq) & pos.opp();
-
-      if (my && !op && my.count() == 1) {
-        checks_[my.bti()] |= moves_[my.bti()] & ~db::between(fr, sq);
-        // abzug_[my.bti()] |= moves_[my.bti()] & ~db::between(fr, sq);
-      }
-    }
+    for (auto fr : ci.blockers)
+      checks_[fr] |= moves_[fr] & ~db::ray(ci.ksq, fr);
   }
 
   void G::add_move(Move m, MoveList& list, core::Pos& pos) {
@@ -128,10 +99,10 @@ namespace gen {
     list.push_back(m);
   }
 
-  void G::gen(int fr, u64 dest, MoveList& list, core::Pos& pos) {
+  HOT void G::gen(int fr, u64 dest, MoveList& list, core::Pos& pos) {
     int p = pos.piece(fr);
 
-    for (auto to : u64(pos.moves(fr) & dest)) {
+    for (auto to : u64(pos.legal(fr, pins(pos)) & dest)) {
       int cp = pos.piece(to);
 
       bool ep = ((p >> 1) == PAWN && to == pos.ep()); // ? true : false;
@@ -145,21 +116,21 @@ namespace gen {
         add_move(Move(fr, to), list, pos);
     }
   }
-  void G::gen(int fr, MoveList& list, core::Pos& pos) {
-    for (auto to : u64(K_MASK[fr] & ~pos.own())) {
+  HOT void G::gen(int fr, MoveList& list, core::Pos& pos) {
+    for (auto to : pos.legal(fr, pins(pos))) {
       if (pos.piece(to))
         add_tac(Move(fr, to), list, pos);
       else
         add_move(Move(fr, to), list, pos);
     }
   }
-  void G::gen_esc(MoveList& list, core::Pos& pos) {
+  HOT void G::gen_esc(MoveList& list, core::Pos& pos) {
     assert(pos.check());
 
     auto side = pos.side();
     auto k    = pos.king(side);
     auto sq   = pos.king_sq(side);
-    auto atck = pos.atck_to(sq, !side);
+    auto atck = pos.checkers();
 
     gen(sq, list, pos);
 
@@ -178,11 +149,11 @@ namespace gen {
     for (auto fr : u64(pos.own() & ~k))
       gen(fr, dest, list, pos);
   }
-  void G::gen_tactical(MoveList& list, core::Pos& pos) {
+  HOT void G::gen_tactical(MoveList& list, core::Pos& pos) {
     u64 op;
 
     for (auto sq : pos.own())
-      moves_[sq] = pos.moves(sq);
+      moves_[sq] = pos.legal(sq, pins(pos));
 
     find_checks(pos);
     find_proms(pos);
@@ -192,7 +163,7 @@ namespace gen {
 
       op = pc == PAWN ? u64(pos.opp() | bit(pos.ep())) : pos.opp();
 
-      for (auto to : u64((moves_[fr] & (checks_[fr] | op)) | proms_[fr])) {
+      for (auto to : u64((moves_[fr] & (checks_[fr] | op)) | proms(fr))) {
         if (pc == PAWN && (bit(to) & PROM))
           for (auto pp : { QUEEN, ROOK, BISHOP, KNIGHT })
             add_tac(Move(fr, to, pp), list, pos);
@@ -201,11 +172,11 @@ namespace gen {
       }
     }
   }
-  void G::gen_cp_prom(MoveList& list, core::Pos& pos) {
+  HOT void G::gen_cp_prom(MoveList& list, core::Pos& pos) {
     u64 op;
 
     for (auto sq : pos.own())
-      moves_[sq] = pos.moves(sq);
+      moves_[sq] = pos.legal(sq, pins(pos));
 
     find_checks(pos);
     find_proms(pos);
@@ -215,10 +186,11 @@ namespace gen {
 
       op = pc == PAWN ? u64(pos.opp() | bit(pos.ep())) : pos.opp();
 
-      for (auto to : u64((moves_[fr] & (checks_[fr] | op)) | proms_[fr])) {
+      u64 pr = proms(fr);
+      for (auto to : u64((moves_[fr] & (checks_[fr] | op)) | pr)) {
         int cp  = pos.pc(to);
         bool ep = (pc == PAWN && to == pos.ep());
-        if (!(cp || ep) && !(bit(to) & proms_[fr]))
+        if (!(cp || ep) && !(bit(to) & pr))
           continue;
 
         if (pc == PAWN && (bit(to) & PROM))
@@ -229,16 +201,100 @@ namespace gen {
       }
     }
   }
-  void G::gen_non_tactical(MoveList& list, core::Pos& pos) {
+  HOT void G::gen_checks(MoveList& list, core::Pos& pos) {
     u64 op;
 
     for (auto fr : pos.own()) {
       op = pos.pc(fr) == PAWN ? u64(pos.opp() | bit(pos.ep())) : pos.opp();
 
-      for (auto to : u64((moves_[fr] & ~(checks_[fr] | op)) & ~proms_[fr])) {
+      for (auto to : u64(moves_[fr] & checks_[fr] & ~op & ~proms(fr)))
+        add_tac(Move(fr, to), list, pos);
+    }
+  }
+  HOT void G::gen_non_tactical(MoveList& list, core::Pos& pos) {
+    u64 op;
+
+    for (auto fr : pos.own()) {
+      op = pos.pc(fr) == PAWN ? u64(pos.opp() | bit(pos.ep())) : pos.opp();
+
+      for (auto to : u64((moves_[fr] & ~(checks_[fr] | op)) & ~proms(fr))) {
         assert(!pos.piece(to));
         add_move(Move(fr, to), list, pos);
       }
     }
   }
-} // namespace gen
\ No newline at end of file
+
+  /// Picker ///
+
+  Move Picker::next() {
+
+    for (;;) {
+      if (stage_ == TT) {
+        stage_ = CAPTS_GEN;
+        Move m(tt_);
+        if (tt_ && pos_.is_legal(m, g_.pins(pos_))) {
+          m.set(32000);
+          return pos_.is_tactical(m) ? m : quiet(m);
+        }
+      } else if (stage_ == CAPTS_GEN) {
+        g_.gen_cp_prom(list_, pos_);
+        stage_ = CAPTS;
+      } else if (stage_ == CAPTS) {
+        while (cur_ < list_.size()) {
+          Move m = best();
+          if (m.frto() == tt_)
+            continue;
+          if (losing(m))
+            list_[bad_++] = m;
+          else
+            return m;
+        }
+        stage_ = KILLER_0;
+      } else if (stage_ == KILLER_0 || stage_ == KILLER_1) {
+        int i = stage_ == KILLER_1;
+        Move m(killer_[i]);
+        stage_++;
+        if (m.frto() && m.frto() != tt_ && !pos_.is_tactical(m)
+            && pos_.is_legal(m, g_.pins(pos_)) && !g_.checked(m)) {
+          m.set(30000 + 3 - i);
+          return quiet(m);
+        }
+      } else if (stage_ == QUIETS_GEN) {
+        g_.gen_checks(list_, pos_);
+        g_.gen_non_tactical(list_, pos_);
+        stage_ = QUIETS;
+      } else if (stage_ == QUIETS) {
+        while (cur_ < list_.size()) {
+          Move m = best();
+          if (m.frto() != tt_ && !is_killer(m))
+            return quiet(m);
+        }
+        cur_   = 0;
+        stage_ = BAD_CAPTS;
+      } else if (stage_ == BAD_CAPTS) {
+        if (cur_ < bad_)
+          return list_[cur_++];
+        stage_ = END;
+      } else if (stage_ == EVASION_GEN) {
+        g_.gen_esc(list_, pos_);
+        stage_ = EVASION;
+      } else if (stage_ == QS_GEN) {
+        if (do_checks_)
+          g_.gen_tactical(list_, pos_);
+        else
+          g_.gen_cp_prom(list_, pos_);
+        stage_ = QS;
+      } else if (stage_ == EVASION || stage_ == QS) {
+        while (cur_ < list_.size()) {
+          Move m = best();
+          if (stage_ == EVASION)
+            return pos_.is_tactical(m) ? m : quiet(m);
+          if (!losing(m))
+            return m;
+        }
+        stage_ = END;
+      } else
+        return Move::none();
+    }
+  }
+} // namespace gen
@@ -31,7 +31,18 @@ namespace gen {
     return p | ((frto >> 6) & 0x3F) << 4;
   }
 
-  // history
+  // search stack entry, 16 bytes: 4 plies per cache line
+  struct Ply {
+    Move move          = Move::none(); // played @ply
+    int eval           = SCORE_NONE;   // static, none in check
+    uint16_t killer[2] = { 0, 0 };
+    uint16_t tt_move   = 0;
+    uint8_t cp         = EMPTY; // captured by move
+  };
+  static_assert(sizeof(Ply) == 16);
+
+  // history & the search stack: one contiguous, preallocated
+  // array of plies, nothing is allocated while searching
   class Heuristic {
 
    public:
@@ -39,24 +50,24 @@ namespace gen {
       clear();
     }
     void clear() {
-      killer_.fill(0);
       history_.fill(0);
-      table_move_.fill(0);
+      stack_.fill(Ply());
       size_ = 0;
     }
     void add_killer(uint16_t m) {
-      if (killer(0) != m && killer(1) != m) {
-        killer_[1][size_] = killer_[0][size_];
-        killer_[0][size_] = m;
+      Ply& e = stack_[size_];
+      if (e.killer[0] != m && e.killer[1] != m) {
+        e.killer[1] = e.killer[0];
+        e.killer[0] = m;
       }
     }
     uint16_t killer(int i) const {
-      return killer_[i][size_];
+      return stack_[size_].killer[i];
     }
     void clear_gc() {
       for (int i = size_ + 2; i < MAX_DEPTH; ++i) {
-        killer_[0][i] = 0;
-        killer_[1][i] = 0;
+        stack_[i].killer[0] = 0;
+        stack_[i].killer[1] = 0;
       }
     }
     void add_history(uint16_t m, int p, int sc) {
@@ -75,20 +86,14 @@ namespace gen {
     int sply() const {
       return size_;
     }
+    Ply& ply(int i) {
+      return stack_[i];
+    }
     uint16_t tt_move() const {
-      return table_move_[size_];
+      return stack_[size_].tt_move;
     }
     void set_tt_move(uint16_t m) {
-      table_move_[size_] = m;
-    }
-    void set_pv(const PV& pv) {
-      table_move_.fill(0);
-      int i = pv.size() - 1;
-      int j = size_;
-      while (i--)
-        table_move_[j--] = pv[i].frto();
-      assert(i == 0);
-      assert(j == 0);
+      stack_[size_].tt_move = m;
     }
     void process_serchinfo(uint16_t m, int p, int d, int sc, int a, int b) {
 
@@ -99,17 +104,17 @@ namespace gen {
           return;
         }
       } else {
-        if (killer(0) == m)
-          killer_[0][size_] = 0;
-        else if (killer(1) == m)
-          killer_[1][size_] = 0;
+        Ply& e = stack_[size_];
+        if (e.killer[0] == m)
+          e.killer[0] = 0;
+        else if (e.killer[1] == m)
+          e.killer[1] = 0;
       }
     }
 
    private:
     array_rn<int, 1024> history_;
-    array_rn<uint16_t, N_CLR, MAX_DEPTH> killer_;
-    array_rn<uint16_t, MAX_DEPTH> table_move_;
+    alignas(64) std::array<Ply, MAX_DEPTH + 1> stack_;
 
     int size_;
 
@@ -119,13 +124,29 @@ namespace gen {
   };
   class G {
 
+    friend class Picker;
+
    public:
-    G(Heuristic& h) : h_(h), moves_{ 0 }, checks_{ 0 }, proms_{ 0 } {
+    // no clears: moves_ & checks_ are written for the own squares
+    // before they are read, proms_ is a square set
+    G(Heuristic& h) : h_(h) {
     }
 
     bool checked(Move m) const {
       return checks_[m.fr()] & bit(m.to());
     }
+    // once per node: pins (the generators emit legal moves only)
+    // & check squares
+    const core::CheckInfo& info(const core::Pos& pos) {
+      if (!has_info_) {
+        info_     = pos.check_info();
+        has_info_ = true;
+      }
+      return info_;
+    }
+    const core::Pins& pins(const core::Pos& pos) {
+      return info(pos).pins;
+    }
     // bool abzug(Move m) const { return abzug_[m.fr()] & bit(m.to()); }
 
     void all(MoveList& list, core::Pos& pos) {
@@ -165,11 +186,17 @@ namespace gen {
 
    private:
     Heuristic& h_;
+    core::CheckInfo info_;
+    bool has_info_ = false;
     // note: sequenz -> first moves_ then Checks & Proms
 
     std::array<uint64_t, 64> moves_;
     std::array<uint64_t, 64> checks_;
-    std::array<uint64_t, 64> proms_;
+    u64 proms_ = 0; // pawns on the 7th
+
+    u64 proms(int fr) const {
+      return (proms_ & bit(fr)) ? moves_[fr] : 0;
+    }
 
     void find_proms(const core::Pos& pos);
     void find_checks(const core::Pos& pos);
@@ -182,6 +209,7 @@ namespace gen {
     void gen_esc(MoveList& list, core::Pos& pos);
     void gen_tactical(MoveList& list, core::Pos& pos);
     void gen_cp_prom(MoveList& list, core::Pos& pos);
+    void gen_checks(MoveList& list, core::Pos& pos);
     void gen_non_tactical(MoveList& list, core::Pos& pos);
 
     int score(int pc, int cp, int pp) {
@@ -193,6 +221,83 @@ namespace gen {
       return (cp * 6) + (5 - pc) + (pp * 5) + 31000;
     }
   };
+
+  // staged: a stage is generated when reached, next() selects the
+  // best move left in the stage (no sort), Move::none() @end
+  // search:  tt, captures, killers, quiet checks & quiets, losing
+  //          captures (see < 0)
+  // quiesce: captures (+ quiet checks @do_checks), no losing ones
+  // check:   all evasions
+  class Picker {
+
+   public:
+    Picker(Heuristic& h, core::Pos& pos, MoveList& list)
+      : pos_(pos), list_(list), g_(h), tt_(h.tt_move()),
+        killer_{ h.killer(0), h.killer(1) } {
+      list_.clear();
+      stage_ = pos.check() ? EVASION_GEN : TT;
+    }
+    Picker(Heuristic& h, core::Pos& pos, MoveList& list, bool do_checks)
+      : pos_(pos), list_(list), g_(h), do_checks_(do_checks) {
+      list_.clear();
+      stage_ = pos.check() ? EVASION_GEN : QS_GEN;
+    }
+
+    Move next();
+    bool gives_check(Move m) {
+      return pos_.gives_check(m, g_.info(pos_));
+    }
+    // the quiets returned so far, all of them searched: history malus
+    const uint16_t* quiets() const {
+      return quiets_;
+    }
+    int quiets_size() const {
+      return quiets_n_;
+    }
+
+   private:
+    // clang-format off
+    enum Stage {
+      TT, CAPTS_GEN, CAPTS, KILLER_0, KILLER_1, QUIETS_GEN, QUIETS, BAD_CAPTS,
+      EVASION_GEN, EVASION, QS_GEN, QS,
+      END
+    };
+    // clang-format on
+
+    core::Pos& pos_;
+    MoveList& list_;
+    G g_;
+
+    int stage_;
+    uint16_t tt_        = 0;
+    uint16_t killer_[2] = { 0, 0 }; // as the node started
+    bool do_checks_     = false;
+    size_t cur_         = 0; // next of the stage
+    size_t bad_         = 0; // losing captures: list_[0, bad_)
+    int quiets_n_       = 0;
+    uint16_t quiets_[MoveList::N]; // frto, not initialised
+
+    // swap the best of [cur_, end) to cur_
+    Move best() {
+      auto b = std::max_element(list_.begin() + cur_, list_.end());
+      std::swap(*b, list_[cur_]);
+      return list_[cur_++];
+    }
+    Move quiet(Move m) {
+      assert(quiets_n_ < int(MoveList::N));
+      quiets_[quiets_n_++] = m.frto();
+      return m;
+    }
+    // a killer that checks is picked with the checks
+    bool is_killer(Move m) const {
+      return (m.frto() == killer_[0] || m.frto() == killer_[1])
+          && !g_.checked(m);
+    }
+    bool losing(Move m) {
+      return !m.pp() && VALUE[pos_.pc(m.fr())] > VALUE[pos_.pc(m.to())]
+          && pos_.see(m) < 0;
+    }
+  };
 } // namespace gen
 
 #endif
\ No newline at end of file
@@ -0,0 +1,270 @@
+/*---------------------------------------------------------------------
+
+  Bienchen - UCI chess engine
+  © 2022 Manuel Schenske
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+---------------------------------------------------------------------*/
+
+#include "hash.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace ht {
+
+  Table::~Table() {
+    unmap();
+  }
+  void Table::unmap() {
+    if (fd_ >= 0)
+      mem::unshare(map_name_, map_, bytes_, fd_);
+    else
+      mem::dealloc(map_, bytes_);
+    fd_ = -1;
+  }
+  bool Table::resize(int mb, bool large) {
+    mb = std::clamp(mb, HASH_MIN, HASH_MAX);
+
+    // shared: one line in front holds the generation
+    mem::Pages pages;
+    int fd       = -1;
+    size_t head  = shared() ? sizeof(Bucket) : 0;
+    size_t bytes = (size_t(mb) << 20) + head;
+    auto* p      = static_cast<char*>(
+      shared() ? mem::shared(name_, bytes, large, pages, fd)
+                    : mem::alloc(bytes, large, pages));
+
+    // keep the old table
+    if (!p)
+      return false;
+
+    unmap();
+    fd_       = fd;
+    map_name_ = name_;
+    map_      = p;
+    b_     = reinterpret_cast<Bucket*>(p + head);
+    gen_   = head ? reinterpret_cast<uint64_t*>(p) : &own_gen_;
+    n_     = (size_t(mb) << 20) / sizeof(Bucket);
+    bytes_ = bytes;
+    large_ = large;
+    pages_ = pages;
+    return true;
+  }
+  bool Table::share(const std::string& name) {
+    std::string old = name_;
+
+    name_ = name;
+    if (resize(size_mb()))
+      return true;
+    name_ = old;
+    return false;
+  }
+  void Table::clear(int threads) {
+    // private: give the pages back, no fill, the table costs no
+    // memory before it is used again
+    if (!shared() && pages_ != mem::HUGETLB && mem::discard(map_, bytes_))
+      return;
+
+    size_t n = std::clamp<size_t>(threads, 1, n_);
+    std::vector<std::thread> v;
+
+    for (size_t i = 0; i < n; i++)
+      v.emplace_back([this, i, n] {
+        std::fill(b_ + n_ * i / n, b_ + n_ * (i + 1) / n, Bucket{});
+      });
+    for (auto& x : v)
+      x.join();
+  }
+  int Table::hashfull() const {
+    int r = 0;
+    int g = gen();
+    for (size_t i = 0; i < 1000 / N_SLOTS && i < n_; i++)
+      for (auto& w : b_[i]) {
+        Entry a = load(w);
+        r += a.flag() && a.gen() == g;
+      }
+    return r;
+  }
+
+  static uint64_t checksum(const Bucket* b, size_t n, uint64_t h = 0) {
+    for (size_t i = 0; i < n; i++)
+      for (auto w : b[i])
+        h = (h ^ w) * 0x100000001B3ull;
+    return h;
+  }
+  // the checksum covers the bytes as written: copy a chunk, sum it,
+  // write it, the header goes in last
+  bool Table::write(const std::string& file) const {
+
+    std::ofstream f(file, std::ios::binary);
+    if (!f)
+      return false;
+
+    Header h;
+    h.gen     = gen();
+    h.buckets = n_;
+
+    f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    std::vector<Bucket> buf(1 << 14);
+    for (size_t i = 0; i < n_ && f; i += buf.size()) {
+      size_t n = std::min(buf.size(), n_ - i);
+
+      std::copy(b_ + i, b_ + i + n, buf.begin());
+      h.checksum = checksum(buf.data(), n, h.checksum);
+      f.write(reinterpret_cast<const char*>(buf.data()), n * sizeof(Bucket));
+    }
+    f.seekp(0);
+    f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    return bool(f);
+  }
+  // a first pass checks the file, the table is only touched
+  // if it is good (unless it changes between the passes)
+  bool Table::read(const std::string& file) {
+
+    // other engines search in a shared table, no clear
+    if (shared())
+      return false;
+
+    std::ifstream f(file, std::ios::binary);
+    Header h, ok;
+
+    if (!f.read(reinterpret_cast<char*>(&h), sizeof(h))
+        || std::memcmp(h.magic, ok.magic, sizeof(h.magic))
+        || h.version != ok.version || h.slots != ok.slots || !h.buckets)
+      return false;
+
+    // the keys of old bucket i: index() * n_ / buckets, any sizes
+    __extension__ typedef unsigned __int128 u128;
+    auto lo = [&](uint64_t i) { return uint64_t(u128(i) * n_ / h.buckets); };
+    auto hi = [&](uint64_t i) {
+      return uint64_t((u128(i + 1) * n_ + h.buckets - 1) / h.buckets);
+    };
+    std::vector<Bucket> buf(1 << 14);
+
+    auto pass = [&](bool load) {
+      uint64_t sum = 0;
+
+      f.clear();
+      f.seekg(sizeof(h));
+      for (uint64_t i = 0; i < h.buckets; i += buf.size()) {
+        size_t n = std::min<uint64_t>(buf.size(), h.buckets - i);
+
+        if (!f.read(reinterpret_cast<char*>(buf.data()), n * sizeof(Bucket)))
+          return false;
+        sum = checksum(buf.data(), n, sum);
+        if (load)
+          for (size_t j = 0; j < n; j++)
+            for (uint64_t t = lo(i + j); t < hi(i + j); t++)
+              merge(buf[j], t);
+      }
+      return sum == h.checksum && f.peek() == EOF;
+    };
+
+    if (!pass(false))
+      return false;
+
+    clear();
+    std::atomic_ref<uint64_t>(*gen_).store(h.gen, std::memory_order_relaxed);
+    return pass(true);
+  }
+  // a key of old bucket i of N has an index in [i * n / N,
+  // (i + 1) * n / N) here: each of them gets a copy (the 16 key bits
+  // sort out the others), no key bits are needed, the deepest stay
+  void Table::merge(const Bucket& b, uint64_t i) {
+    for (auto w : b) {
+      Entry a = std::bit_cast<Entry>(w);
+      if (!a.flag())
+        continue;
+
+      // an empty slot, else the lowest depth
+      Bucket& r   = b_[i];
+      uint64_t* s = &r[0];
+      for (auto& x : r) {
+        if (!load(x).flag()) {
+          s = &x;
+          break;
+        }
+        if (load(x).depth() < load(*s).depth())
+          s = &x;
+      }
+      if (!load(*s).flag() || load(*s).depth() <= a.depth())
+        store(*s, a);
+    }
+  }
+
+  // payload is a function of the stored key bits,
+  // a torn slot pairs the key of one write with data of another
+  static uint16_t move_of(uint16_t k) {
+    return k * 0x9E37 + 1;
+  }
+  static int score_of(uint16_t k) {
+    return int16_t(k ^ 0x5A5A) / 4;
+  }
+  bool stress(int threads) {
+
+    constexpr int N = 1 << 22;
+
+    Table t(HASH_MIN, false);
+    std::atomic<uint64_t> hits{ 0 };
+    std::atomic<uint64_t> errors{ 0 };
+    std::vector<std::thread> v;
+
+    // shared keys, so threads fight over the same slots
+    std::mt19937_64 rng(0);
+    std::vector<uint64_t> keys(1 << 16);
+    for (auto& key : keys)
+      key = rng();
+
+    for (int i = 0; i < threads; i++)
+      v.emplace_back([&, i] {
+        std::mt19937_64 rng(i + 1);
+        uint64_t h = 0, err = 0;
+        Stats s;
+
+        for (int j = 0; j < N; j++) {
+          uint64_t key = keys[rng() & 0xFFFF];
+          uint16_t k   = key;
+          int depth    = (key >> 32) % 64;
+          int flag     = 1 + (key >> 40) % 3;
+
+          t.rem(key, Move(move_of(k)), depth, score_of(k), flag, s);
+
+          Entry r;
+          key = keys[rng() & 0xFFFF];
+          if (t.e(key, 0, r, s)) {
+            h++;
+            err += r.move_ != move_of(r.key_) || r.score_ != score_of(r.key_);
+          }
+          if (uint16_t m = t.move(key, s))
+            err += m != move_of(key);
+        }
+        hits += h;
+        errors += err;
+      });
+
+    for (auto& x : v)
+      x.join();
+
+    std::cout << "info string hashtest threads " << threads << " stores "
+              << uint64_t(threads) * N << " hits " << hits << " errors "
+              << errors << std::endl;
+    return errors == 0;
+  }
+} // namespace ht
@@ -22,62 +22,70 @@
 
 #include "array_rn.h"
 #include "main.h"
+#include "mem.h"
 #include "move.h"
 
-#include <random>
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <string>
 
 namespace hash {
 
   typedef array_rn<uint64_t, N_PT, N_SQ> hash_piece_t;
-  typedef array_rn<uint64_t, N_PT, N_SQ, N_SQ> hash_move_t;
 
-  static std::mt19937_64 rng(1632933495);
+  // splitmix64, std::mt19937_64 isn't constexpr
+  struct Rng {
+    uint64_t s_;
 
-  static uint64_t rd_key() {
+    constexpr uint64_t operator()() {
+      uint64_t z = (s_ += 0x9E3779B97F4A7C15);
+      z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+      z          = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+      return z ^ (z >> 31);
+    }
+  };
+
+  constexpr uint64_t rd_key(Rng& rng) {
     uint64_t r;
     int bit_count;
 
     // filter high/low bit.counts
     do {
       r         = rng();
-      bit_count = __builtin_popcountll(r);
+      bit_count = std::popcount(r);
     } while (bit_count < 3 || bit_count > 61);
 
     return r;
   }
-  static hash_piece_t make_piece_keys() {
+  consteval hash_piece_t make_piece_keys() {
 
     hash_piece_t r;
+    Rng rng{ 1632933495 };
     for (auto sq : UNIVERSE)
       for (int p = EMPTY; p <= WK; p++)
-        r[p][sq] = rd_key();
+        r[p][sq] = rd_key(rng);
 
     return r;
   }
-  static const hash_piece_t psKey = make_piece_keys();
-  static hash_move_t make_move_keys() {
-
-    hash_move_t r;
-    for (auto fr : UNIVERSE)
-      for (auto to : UNIVERSE)
-        for (int p = EMPTY; p <= WK; p++)
-          r[p][fr][to] = psKey[p][fr] ^ psKey[p][to];
-
-    return r;
-  }
-  static const hash_move_t moveKey = make_move_keys();
+  inline constexpr hash_piece_t psKey = make_piece_keys();
 
   static constexpr uint64_t key(int p, int sq) {
     return psKey[p][sq];
   }
+  // 2 keys of the 7 KB psKey instead of a 460 KB fr x to table
   static constexpr uint64_t move_key(int p, int fr, int to) {
-    return moveKey[p][fr][to];
+    return psKey[p][fr] ^ psKey[p][to];
   }
 } // namespace hash
 
 namespace ht {
 
-  constexpr int SIZE_A = 15753211; // @all 256 MB
+  constexpr int N_SLOTS  = 8;  // entries per bucket
+  constexpr int N_GEN    = 64; // search generations, wrap around
+  constexpr int HASH_MB  = 256;
+  constexpr int HASH_MIN = 1;
+  constexpr int HASH_MAX = 1 << 20; // 1 TB
 
   inline int in(int sc, int ply) {
     assert(sc != SCORE_NONE);
@@ -99,46 +107,214 @@ namespace ht {
     }
     return sc;
   }
+  // bucket index: high bits of key * n, no modulo
+  inline uint64_t index(uint64_t key, uint64_t n) {
+    __extension__ typedef unsigned __int128 u128;
+    return (u128(key) * n) >> 64;
+  }
 
+  // 8 byte entry, the low 16 bits of the key verify the slot
+  // (the high bits already selected the bucket)
   struct Entry {
     enum : uint8_t { UB = 1, LB = 2, XB = 3, PV = 4 };
 
-    uint64_t key_   = 0;
-    uint16_t move_  = 0;
-    int16_t score_  = SCORE_NONE;
-    int8_t depth_   = 0;
-    uint8_t flag_   = 0;
+    uint16_t key_  = 0;
+    uint16_t move_ = 0;
+    int16_t score_ = 0;
+    uint16_t data_ = 0; // depth: bit 0-6, flag: bit 7-9, gen: bit 10-15
+
+    int depth() const {
+      return data_ & 0x7F;
+    }
+    int flag() const {
+      return (data_ >> 7) & 0x7;
+    }
+    int gen() const {
+      return data_ >> 10;
+    }
+    // searches since the last store
+    int age(int gen) const {
+      return (gen - this->gen()) & (N_GEN - 1);
+    }
+    // empty slots have no flag
+    bool is(uint64_t key) const {
+      return flag() && key_ == uint16_t(key);
+    }
+    void set(uint64_t key, uint16_t m, int sc, int depth, int flag, int gen) {
+      assert(depth >= 0 && depth < MAX_DEPTH);
+      key_   = key;
+      move_  = m;
+      score_ = sc;
+      data_  = depth | flag << 7 | gen << 10;
+    }
+  };
+  static_assert(sizeof(Entry) == 8);
+
+  // one cache line per probe, one word per slot
+  struct alignas(64) Bucket : public std::array<uint64_t, N_SLOTS> {};
+  static_assert(sizeof(Bucket) == 64);
+
+  // lock-free: a slot is loaded & stored as a whole word,
+  // so no thread ever sees key & data of two different writes
+  inline Entry load(uint64_t& w) {
+    return std::bit_cast<Entry>(
+      std::atomic_ref<uint64_t>(w).load(std::memory_order_relaxed));
+  }
+  inline void store(uint64_t& w, const Entry& a) {
+    std::atomic_ref<uint64_t>(w).store(
+      std::bit_cast<uint64_t>(a), std::memory_order_relaxed);
+  }
+
+  // counters of one thread, the caller owns them: the table
+  // is shared, a counter inside would be a race
+  struct Stats {
+    uint64_t probes     = 0;
+    uint64_t hits       = 0; // key found
+    uint64_t cutoffs    = 0; // score returned by alphaBeta
+    uint64_t moves      = 0; // tt move found
+    uint64_t stores     = 0;
+    uint64_t overwrites = 0; // other key of this search lost
   };
 
-  class Table : public std::array<Entry, SIZE_A> {
+  class Table {
 
    public:
-    Table() {
-    }
-    void clear() {
-      fill(Entry());
-    }
-    Entry* e(uint64_t key, int depth) {
-      Entry* a = this->begin() + (key % SIZE_A);
-      if (key != a->key_ || depth > a->depth_)
-        return nullptr;
-      return a;
-    }
-    void rem(uint64_t key, Move m, int depth, int sc, int flag) {
-      Entry* a = this->begin() + (key % SIZE_A);
-      if (key != a->key_ || depth > a->depth_) {
-        a->key_   = key;
-        a->move_  = m.frto();
-        a->score_ = sc;
-        a->depth_ = depth;
-        a->flag_  = flag;
+    Table(int mb = HASH_MB, bool large = true) {
+      resize(mb, large);
+    }
+    ~Table();
+    Table(const Table&)            = delete;
+    Table& operator=(const Table&) = delete;
+
+    // new zeroed table, fresh pages aren't committed before first touch
+    bool resize(int mb, bool large);
+    bool resize(int mb) {
+      return resize(mb, large_);
+    }
+    // attach to a named table of all processes with the same name
+    // & size, an empty name switches back to a private table
+    bool share(const std::string& name);
+    bool shared() const {
+      return !name_.empty();
+    }
+    // private: drops the pages, shared or hugetlb (the pages stay):
+    // each thread zeroes one contiguous slice
+    void clear(int threads = 1);
+
+    // snapshot, not while searching, a failed read keeps the table,
+    // no read into a shared table
+    bool write(const std::string& file) const;
+    bool read(const std::string& file);
+    int size_mb() const {
+      return (n_ * sizeof(Bucket)) >> 20;
+    }
+    mem::Pages pages() const {
+      return pages_;
+    }
+    // @go: older entries become the first victims, a shared
+    // table keeps one generation for all its engines
+    void new_search() {
+      std::atomic_ref<uint64_t>(*gen_).fetch_add(1, std::memory_order_relaxed);
+    }
+    int gen() const {
+      return std::atomic_ref<uint64_t>(*gen_).load(std::memory_order_relaxed)
+           & (N_GEN - 1);
+    }
+    // per mille of the first 1000 slots of this generation
+    // (shared: the last search of any engine)
+    int hashfull() const;
+    void prefetch(uint64_t key) {
+      __builtin_prefetch(&bucket(key));
+    }
+    // copy of the slot, the table may change behind our back
+    bool e(uint64_t key, int depth, Entry& r, Stats& s) {
+      s.probes++;
+      for (auto& w : bucket(key)) {
+        r = load(w);
+        if (r.is(key)) {
+          s.hits++;
+          return depth <= r.depth();
+        }
       }
+      return false;
     }
-    uint16_t move(uint64_t key) {
-      Entry* a = this->begin() + (key % SIZE_A);
-      return a->key_ == key ? a->move_ : 0;
+    // replace: same key if deeper, exact or old, else an empty
+    // slot, else the slot with the lowest depth - 8 * age
+    void rem(uint64_t key, Move m, int depth, int sc, int flag, Stats& s) {
+      Bucket& b   = bucket(key);
+      uint64_t* r = &b[0];
+      int r_value = MAX_DEPTH;
+      int g       = gen();
+
+      s.stores++;
+      for (auto& w : b) {
+        Entry a = load(w);
+        if (a.is(key)) {
+          if (depth > a.depth() || flag == Entry::XB || a.gen() != g) {
+            a.set(key, m.frto() ? m.frto() : a.move_, sc, depth, flag, g);
+            store(w, a);
+          }
+          return;
+        }
+        int value = a.flag() ? a.depth() - 8 * a.age(g) : INT_MIN;
+        if (value < r_value) {
+          r       = &w;
+          r_value = value;
+        }
+      }
+      Entry a = load(*r);
+      if (a.flag() && a.gen() == g)
+        s.overwrites++;
+      a.set(key, m.frto(), sc, depth, flag, g);
+      store(*r, a);
+    }
+    uint16_t move(uint64_t key, Stats& s) {
+      for (auto& w : bucket(key)) {
+        Entry a = load(w);
+        if (a.is(key)) {
+          s.moves += a.move_ != 0;
+          return a.move_;
+        }
+      }
+      return 0;
+    }
+
+   private:
+    void* map_        = nullptr; // shared: the generation line, b_
+    Bucket* b_        = nullptr;
+    size_t n_         = 0;
+    size_t bytes_     = 0;
+    bool large_       = true;
+    mem::Pages pages_ = mem::SMALL;
+    uint64_t own_gen_ = 0;
+    uint64_t* gen_    = &own_gen_;
+    int fd_           = -1; // shared: our user lock on map_name_
+    std::string name_;
+    std::string map_name_;
+
+    // the last user of a shared table removes it
+    void unmap();
+    Bucket& bucket(uint64_t key) {
+      return b_[index(key, n_)];
     }
+    void merge(const Bucket& b, uint64_t i);
   };
+
+  // file format of Table::write: header + raw buckets
+  // an entry keeps only the low 16 key bits, the bucket index of
+  // a key can't be rebuilt for another size: an old bucket goes
+  // into all new buckets its keys can index, any size loads
+  struct Header {
+    char magic[4]     = { 'B', 'C', 'H', 'T' };
+    uint32_t version  = 2; // 2: splitmix64 keys
+    uint32_t slots    = N_SLOTS;
+    uint32_t gen      = 0;
+    uint64_t buckets  = 0;
+    uint64_t checksum = 0;
+  };
+
+  // N threads store & probe one small table, checks every hit
+  bool stress(int threads);
 } // namespace ht
 
 #endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+/*---------------------------------------------------------------------
+
+  Bienchen - UCI chess engine
+  © 2022 Manuel Schenske
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+---------------------------------------------------------------------*/
+
+// magic number finder: make magic && ./bienchen-magic > magics.txt
+// prints R_MAGIC & B_MAGIC for main.h, one index bit per mask bit
+
+#include "db.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static std::mt19937_64 rng(1632933495);
+
+// few bits set: more likely magic
+static uint64_t sparse() {
+  return rng() & rng() & rng();
+}
+
+static uint64_t find(int sq, int t) {
+
+  u64 mask  = db::sig_mask_[t][sq];
+  int bits  = mask.count();
+  int n     = 1 << bits;
+  int shift = 64 - bits;
+
+  std::vector<uint64_t> occ(n), atck(n), used(n);
+
+  for (int i = 0; i < n; i++) {
+    u64 blx = 0;
+    int j   = 0;
+
+    for (auto s : mask)
+      if (i & bit(j++))
+        blx |= bit(s);
+
+    occ[i]  = blx;
+    atck[i] = t == db::B ? db::gen_bishop(blx, bit(sq))
+                         : db::gen_rook(blx, bit(sq));
+  }
+
+  for (;;) {
+    uint64_t m = sparse();
+
+    // the high bits make the index
+    if (u64((mask * m) & 0xFF00000000000000).count() < 6)
+      continue;
+
+    std::fill(used.begin(), used.end(), 0);
+
+    bool ok = true;
+    for (int i = 0; i < n && ok; i++) {
+      uint64_t& a = used[occ[i] * m >> shift];
+
+      if (!a)
+        a = atck[i];
+      else if (a != atck[i])
+        ok = false;
+    }
+    if (ok)
+      return m;
+  }
+}
+
+static void print(const char* name, int t) {
+
+  std::printf("static constexpr u64 %s[64] = {", name);
+  for (int sq = A1; sq <= H8; sq++)
+    std::printf("%s0x%016llx%s", sq % 4 ? " " : "\n  ",
+                (unsigned long long)find(sq, t), sq < H8 ? "," : "};\n");
+}
+
+int main() {
+
+  print("R_MAGIC", db::R);
+  print("B_MAGIC", db::B);
+  return EXIT_SUCCESS;
+}
@@ -207,39 +207,39 @@ static constexpr u64 BP_ATCK[64] = {
   0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
   0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000};
 static constexpr u64 R_MAGIC[64] = {
-  0x0080002080400014, 0x0040004010002008, 0xa080088020001000, 0x0080100080080004,
-  0x1080040008000280, 0x0880040080220001, 0x0080020000800100, 0xa200104481002406,
-  0x0019800082204000, 0x0000804000200080, 0x2000808010002000, 0x0121000810002100,
-  0x0040808008000400, 0x0000800200800400, 0x2082008804010200, 0x0020800080004100,
-  0x0420818000204000, 0x0010044000442000, 0x1040828010002008, 0x02001200200a0040,
-  0x0004008004080080, 0x8010818012000400, 0x0002010100020004, 0x1020020000408401,
-  0x4040004080008038, 0x4000400080802000, 0x5000104100200100, 0x400a0042000c1020,
-  0x0008020040040041, 0x0000040080800200, 0x0008010080800200, 0x0000012200008044,
-  0x00004002a2800081, 0x0000201002400040, 0x0010002800200400, 0x2000800800801000,
-  0x0000100801000500, 0x1001000401000208, 0x8000800200800100, 0x5800800040800100,
-  0x0800400080208000, 0x4090104020004000, 0x0020001000808022, 0x0000080010008080,
-  0x1000040008008080, 0x4004040002008080, 0x0101000200010004, 0x0409002040810002,
-  0x4580204000800080, 0x0840200040008180, 0x0000402000110100, 0x0000201001000900,
-  0x0010800400080080, 0x0000800400020080, 0x2040100881020400, 0x0200004400810200,
-  0x0000208000410011, 0x0000802100104001, 0x4083004008200411, 0x0c80200810000501,
-  0x0413001002080005, 0x080a001008040102, 0x0440020100881004, 0x0000002081040042};
+  0x2480011040092280, 0x0840200010004001, 0xc100084100200010, 0x0080080080100004,
+  0x8280280080240002, 0x2200020044080150, 0x0400020100845008, 0x0100008100004032,
+  0x0014802080004000, 0x0003400220100240, 0x0040802000801000, 0x6401002100081000,
+  0x2001000801001004, 0x04e8010410484020, 0x0447000100120004, 0x0a02000102008064,
+  0x00416b8000400090, 0x201004c000492008, 0x0002848020001004, 0x2000808010000800,
+  0x0c01010008000410, 0x0001010002080400, 0x4111340008110210, 0x08002a0008412084,
+  0x00c6400080142080, 0x08a0400040201000, 0x0000110100200040, 0x2400080080100080,
+  0x2006050100100800, 0x120a000200040810, 0x3040221400480110, 0x00020c8200044429,
+  0x1080400080800022, 0x0001824004802010, 0x1120008020801001, 0x1021001001000820,
+  0x0111000801000410, 0x0084800400800200, 0x2050800100800200, 0x0085000049001082,
+  0xa004c01083208001, 0x0850004020024000, 0x8400200100410010, 0x000021001001000c,
+  0x0081000800050010, 0x0200040002008080, 0x1001001200050004, 0x8408005100820014,
+  0x0980028250210100, 0xc020400080201480, 0x4012008440201200, 0x0040801000080080,
+  0x0008000a04008080, 0x0000800200040080, 0x806a03b01a080400, 0x0014084284010600,
+  0x9085450280205202, 0x0200802018420102, 0x0084801040082202, 0x5000100045016009,
+  0x2222002048441102, 0x0095000c00080203, 0x4207100108008204, 0x20001044002c8102};
 static constexpr u64 B_MAGIC[64] = {
-  0x0404108410448600, 0x0042280104008040, 0x0010042080280001, 0x80082048400c0400,
-  0x0104042018002800, 0x0004240440001000, 0x01b84104a0200000, 0x0000804050042000,
-  0x0040080808084049, 0x0800040408204100, 0x2000080204082000, 0x0008082080200010,
-  0x8057040420001002, 0x0000011002110004, 0x0000008808480420, 0x0040020041480800,
-  0x0004024010820200, 0x0220100401022200, 0x0001001024008010, 0x0008002082004000,
-  0x000a000422010000, 0x0300201202012001, 0x0801022084012000, 0x00220000221104a0,
-  0x0003080060a00400, 0x0014204004410400, 0x0220440008002400, 0x0000404004010200,
-  0x0001010000104000, 0x0001010002100081, 0x1001040001040112, 0x0000820000806400,
-  0x0202200402200804, 0x0002080400200120, 0x0006005002010100, 0x4100400a00002200,
-  0x0002020200100808, 0x0010100080004048, 0x0802081200010080, 0x4601010a00010040,
-  0x0001101004001008, 0x0342280208000200, 0x00020c00440a0800, 0x0000004200800800,
-  0x0000200410400402, 0x2020200400200042, 0x0005a41482000400, 0x0002081100200110,
-  0x0200880802100005, 0x00020080c4100000, 0x0040070048120100, 0x8000000104980050,
-  0x0000101182020000, 0x8202200202420000, 0x0020040408404000, 0x0010020084008880,
-  0xa400110410020800, 0x0000011082012000, 0x0010000100411000, 0x0000002400420229,
-  0x0000000004104400, 0x0000000802480200, 0x00000a5001420400, 0x2002040108110100};
+  0x0020020401040011, 0x8010c111111a0000, 0x0490408200452001, 0x8004404081109008,
+  0x0082021022000200, 0x0400821040090002, 0x0210884402208001, 0x0c01010811042a00,
+  0x0600045002480108, 0x0040021001120080, 0x203088008c008428, 0x80100404008a0000,
+  0x0002011040004420, 0x02808208020800a0, 0x00017a0802021094, 0x0011210848020800,
+  0x0040010810440082, 0x0022408808280088, 0x1301081004008010, 0x2704000840102042,
+  0x0008100501400000, 0x0012000901010100, 0x05020812a2842020, 0x0020580202088400,
+  0x0208084060600190, 0x21101c0002048421, 0x1002024098080244, 0x00068080080200ca,
+  0x2001010000104000, 0x0841020051008090, 0x10084040120d0400, 0x60040220049a0100,
+  0x028854100044208b, 0x8002504201040808, 0x0008802400408400, 0x0001200800010104,
+  0x0048020400301010, 0x0210008200002200, 0x4441012102040400, 0x08493100200a0a08,
+  0x0000900808002024, 0x0400640260110800, 0x4002022024080800, 0x8800068401003020,
+  0x141ca10216000400, 0x0201020818408201, 0xc0a0082080a00104, 0x100200a403110080,
+  0x428080cc20208000, 0x60850b0909200008, 0x3042022508480000, 0x0002000a05140080,
+  0x0201040820884400, 0x3500322041010840, 0x0040020822088840, 0x2820880200504268,
+  0x0012002104022004, 0x1408008404010440, 0x8000000084008800, 0x0000c08000840400,
+  0x4d80810112120600, 0x442282e0a0441ac0, 0x0020202001010114, 0x0088011024004080};
 static constexpr u64 RANK_MASK[8] = {
   0x00000000000000FF,
   0x000000000000FF00,
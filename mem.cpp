@@ -0,0 +1,258 @@
+/*---------------------------------------------------------------------
+
+  Bienchen - UCI chess engine
+  © 2022 Manuel Schenske
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+---------------------------------------------------------------------*/
+
+#include "mem.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifndef _WIN32
+#include <fstream>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mem {
+
+  static size_t round_up(size_t bytes, size_t to) {
+    return (bytes + to - 1) / to * to;
+  }
+
+#ifdef _WIN32
+
+  void* alloc(size_t& bytes, bool, Pages& got) {
+    got = SMALL;
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT,
+                        PAGE_READWRITE);
+  }
+  void dealloc(void* p, size_t) {
+    if (p)
+      VirtualFree(p, 0, MEM_RELEASE);
+  }
+  void* shared(const std::string&, size_t, bool, Pages& got, int& fd) {
+    got = SMALL;
+    fd  = -1;
+    return nullptr;
+  }
+  void unshare(const std::string&, void*, size_t, int) {
+  }
+  Pages advise(void*, size_t, bool) {
+    return SMALL;
+  }
+  bool discard(void*, size_t) {
+    return false;
+  }
+
+#else
+
+  static void* map(size_t bytes, int flags) {
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+  }
+
+  void* alloc(size_t& bytes, bool large, Pages& got) {
+    got = SMALL;
+
+    if (!large)
+      return map(bytes, 0);
+
+    bytes = round_up(bytes, HUGE_PAGE);
+
+#ifdef MAP_HUGETLB
+    // explicit: needs reserved pages (vm.nr_hugepages)
+    if (void* p = map(bytes, MAP_HUGETLB)) {
+      got = HUGETLB;
+      return p;
+    }
+#endif
+    // transparent: over-map, trim to 2 MB alignment
+    auto* raw = static_cast<char*>(map(bytes + HUGE_PAGE, 0));
+    if (!raw)
+      return nullptr;
+
+    auto addr  = reinterpret_cast<uintptr_t>(raw);
+    auto* p    = reinterpret_cast<char*>(round_up(addr, HUGE_PAGE));
+    size_t pre = p - raw;
+
+    if (pre)
+      munmap(raw, pre);
+    munmap(p + bytes, HUGE_PAGE - pre);
+
+    got = advise(p, bytes, true);
+    return p;
+  }
+  void dealloc(void* p, size_t bytes) {
+    if (p)
+      munmap(p, bytes);
+  }
+  // madvise succeeds on any shmem mapping, the huge pages come only
+  // if the mount & shmem_enabled allow them: ask the kernel (smaps
+  // THPeligible, 5.x), else go by shmem_enabled alone
+  static bool shmem_thp(void* p) {
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    auto addr = reinterpret_cast<uintptr_t>(p);
+    bool in   = false;
+
+    while (std::getline(smaps, line)) {
+      // a mapping starts with "<from>-<to> "
+      size_t dash = line.find('-');
+      if (dash != std::string::npos && dash < line.find(' '))
+        in = std::strtoull(line.c_str(), nullptr, 16) == addr;
+      else if (in && line.rfind("THPeligible:", 0) == 0)
+        return std::atoi(line.c_str() + 12) == 1;
+    }
+
+    std::ifstream f("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+    std::string mode;
+    while (f >> mode)
+      if (mode.front() == '[')
+        return mode != "[never]" && mode != "[deny]";
+    return false;
+  }
+  // O_EXCL: one creator sizes it, the others wait for the size &
+  // must agree. Each user keeps the fd open with a shared flock, the
+  // last one to leave gets the exclusive lock & removes the name.
+  void* shared(const std::string& name, size_t bytes, bool large, Pages& got,
+               int& fd) {
+    got = SMALL;
+    fd  = -1;
+
+    std::string path = "/" + name;
+    struct stat st;
+
+    for (int tries = 0; tries < 100 && fd < 0; tries++) {
+      bool create = true;
+      if ((fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600)) < 0) {
+        create = false;
+        fd     = shm_open(path.c_str(), O_RDWR, 0);
+      }
+      // removed by its last user in between
+      if (fd < 0 && errno == ENOENT)
+        continue;
+      if (fd < 0 || flock(fd, LOCK_SH)
+          || (create && ftruncate(fd, bytes))) {
+        if (create)
+          shm_unlink(path.c_str());
+        if (fd >= 0)
+          close(fd);
+        return nullptr;
+      }
+      // the creator still sizes it
+      for (int i = 0; i < 100 && !fstat(fd, &st) && !st.st_size; i++)
+        usleep(1000);
+
+      // the name may have gone before our lock: try again
+      struct stat now;
+      int cur   = shm_open(path.c_str(), O_RDONLY, 0);
+      bool same = cur >= 0 && !fstat(cur, &now) && now.st_ino == st.st_ino;
+      if (cur >= 0)
+        close(cur);
+      if (!same) {
+        close(fd);
+        fd = -1;
+      }
+    }
+    if (fd < 0)
+      return nullptr;
+
+    // another size: mapping past its end would be SIGBUS
+    void* p = nullptr;
+    if (size_t(st.st_size) == bytes) {
+      p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      p = p == MAP_FAILED ? nullptr : p;
+    }
+    if (!p) {
+      unshare(name, nullptr, 0, fd);
+      fd = -1;
+      return nullptr;
+    }
+    if ((got = advise(p, bytes, large)) == THP && !shmem_thp(p))
+      got = REQUESTED;
+    return p;
+  }
+  void unshare(const std::string& name, void* p, size_t bytes, int fd) {
+    if (p)
+      munmap(p, bytes);
+    if (!flock(fd, LOCK_EX | LOCK_NB))
+      shm_unlink(("/" + name).c_str());
+    close(fd);
+  }
+  Pages advise(void* p, size_t bytes, bool large) {
+#ifdef MADV_HUGEPAGE
+    if (large)
+      return madvise(p, bytes, MADV_HUGEPAGE) ? SMALL : THP;
+    madvise(p, bytes, MADV_NOHUGEPAGE);
+#else
+    (void)p, (void)bytes, (void)large;
+#endif
+    return SMALL;
+  }
+  bool discard(void* p, size_t bytes) {
+    return !madvise(p, bytes, MADV_DONTNEED);
+  }
+
+#endif
+
+  const char* name(Pages p) {
+    static const char* str[] = { "off", "transparent", "hugetlb",
+                                 "requested" };
+    return str[p];
+  }
+
+  /// allocation counter ///
+
+#ifdef COUNT_ALLOCS
+  static thread_local uint64_t allocs_ = 0;
+
+  uint64_t allocs() {
+    return allocs_;
+  }
+} // namespace mem
+
+// every new & new[] of the program ends here
+void* operator new(size_t bytes) {
+  mem::allocs_++;
+  if (void* p = std::malloc(bytes ? bytes : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+#else
+  uint64_t allocs() {
+    return 0;
+  }
+} // namespace mem
+#endif
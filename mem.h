@@ -0,0 +1,65 @@
+/*---------------------------------------------------------------------
+
+  Bienchen - UCI chess engine
+  © 2022 Manuel Schenske
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+---------------------------------------------------------------------*/
+
+#ifndef MEM_H
+#define MEM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mem {
+
+  constexpr size_t HUGE_PAGE = 1 << 21; // 2 MB
+
+  // what the kernel gave us, REQUESTED: asked for transparent huge
+  // pages, but the backing (shmem/tmpfs) won't use them
+  enum Pages { SMALL, THP, HUGETLB, REQUESTED };
+
+  // zeroed & page aligned, committed on first touch
+  // large: try MAP_HUGETLB, then 2 MB aligned + MADV_HUGEPAGE
+  void* alloc(size_t& bytes, bool large, Pages& got);
+  void dealloc(void* p, size_t bytes);
+
+  // named segment (/dev/shm/<name>) other processes can attach to,
+  // created zeroed, nullptr if it exists with another size,
+  // THP only if the kernel has the mapping eligible for them;
+  // fd stays open for unshare(), it marks this process as a user
+  void* shared(const std::string& name, size_t bytes, bool large, Pages& got,
+               int& fd);
+  // unmap, the last user removes the segment. A segment of a
+  // crashed engine stays, rm /dev/shm/<name> (or the next engine
+  // with the same name & size uses it & removes it @exit)
+  void unshare(const std::string& name, void* p, size_t bytes, int fd);
+
+  // (un)mark an existing 2 MB aligned region for transparent huge pages
+  Pages advise(void* p, size_t bytes, bool large);
+
+  // drop the pages of a private mapping, they read zero & are
+  // committed again on first touch, false if the kernel can't
+  bool discard(void* p, size_t bytes);
+
+  const char* name(Pages p);
+
+  // heap allocations (operator new) of the calling thread,
+  // counted @make allocs (COUNT_ALLOCS), else always 0
+  uint64_t allocs();
+} // namespace mem
+
+#endif
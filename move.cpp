@@ -60,8 +60,3 @@ std::ostream& operator<<(std::ostream& os, const Move& m) {
   return os << coordinate[m.fr()] + coordinate[m.to()] + prom_piece[m.pp()]
                  + wspace;
 }
-std::ostream& operator<<(std::ostream& os, PV& list) {
-  for (Move m : list)
-    os << m;
-  return os;
-}
\ No newline at end of file
@@ -20,7 +20,9 @@
 #ifndef MOVE_H
 #define MOVE_H
 
-#include <algorithm> // stable_sort
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -36,14 +38,10 @@ class Move {
     : frto_(fr | (to << 6) | (pp << 12)), score_(0) {
   }
 
-  constexpr Move(const Move& o) : frto_(o.frto_), score_(o.score_) {
-  }
+  // trivial: MoveList keeps its moves in raw storage
+  constexpr Move(const Move& o)            = default;
+  constexpr Move& operator=(const Move& o) = default;
   Move(std::string& s);
-  constexpr Move& operator=(const Move& o) {
-    frto_  = o.frto_;
-    score_ = o.score_;
-    return *this;
-  }
   Move& operator=(std::string& s) {
     *this = Move(s);
     return *this;
@@ -103,29 +101,51 @@ class Move {
   int16_t score_ = 0;
 };
 
-class MoveList : public std::vector<Move> {
+// fixed capacity, no heap: lives on the stack or in Search,
+// the storage isn't initialised (a union member isn't constructed)
+class MoveList {
 
  public:
+  static constexpr size_t N = 256; // max. legal moves are 218
+
   MoveList() {
-    reserve(128);
-  };
-  void sort() {
-    std::stable_sort(begin(), end(), [](Move i, Move j) { return i > j; });
   }
-};
-
-class PV : public std::vector<Move> {
+  MoveList(const MoveList&)            = delete;
+  MoveList& operator=(const MoveList&) = delete;
 
- public:
-  void replace(const Move m0, PV& pv) {
-    clear();
-    push_back(m0);
-    for (auto mi : pv)
-      push_back(mi);
+  void clear() {
+    size_ = 0;
+  }
+  size_t size() const {
+    return size_;
   }
+  bool empty() const {
+    return size_ == 0;
+  }
+  void push_back(Move m) {
+    assert(size_ < N);
+    moves_[size_++] = m;
+  }
+  template <typename... A> void emplace_back(A... a) {
+    push_back(Move(a...));
+  }
+  Move& operator[](size_t i) {
+    return moves_[i];
+  }
+  Move* begin() {
+    return moves_;
+  }
+  Move* end() {
+    return moves_ + size_;
+  }
+
+ private:
+  size_t size_ = 0;
+  union {
+    Move moves_[N];
+  };
 };
 
 std::ostream& operator<<(std::ostream& os, const Move& m);
-std::ostream& operator<<(std::ostream& os, PV& list);
 
 #endif
\ No newline at end of file
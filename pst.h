@@ -27,8 +27,6 @@
 
 namespace pst {
 
-  typedef array_rn<int, N_PT, N_SQ, N_SQ> delta_t;
-
   // clang-format off
   static constexpr int pst[] = {
 
@@ -228,24 +226,43 @@ namespace pst {
            ? pst[index<STAGE>(p, sq)] + pst[(p >> 1) + (STAGE ? 775 : 768)]
            : -pst[index<STAGE>(p, sq)] - pst[(p >> 1) + (STAGE ? 775 : 768)];
   }
-  template <bool STAGE>
-  static constexpr delta_t make_delta_pst() {
+  // mg & eg in one int: mg low, eg high 16 bits (both signed),
+  // a single add or sub updates both halves
+  typedef int32_t score_t;
 
-    delta_t r;
+  static constexpr score_t make_score(int mg, int eg) {
+    return int32_t(uint32_t(eg) << 16) + mg;
+  }
+  static constexpr int mg_value(score_t s) {
+    return int16_t(uint16_t(uint32_t(s)));
+  }
+  // + 0x8000: the borrow of a negative mg half
+  static constexpr int eg_value(score_t s) {
+    return int16_t(uint16_t((uint32_t(s) + 0x8000) >> 16));
+  }
+
+  // 14 x 64 packed pairs: 3.5 KB, deltas are differences of two entries
+  typedef array_rn<score_t, N_PT, N_SQ> square_t;
+
+  static consteval square_t make_square_pst() {
+
+    square_t r{};
     for (int p = BP; p <= WK; p++)
-      for (int fr = A1; fr <= H8; fr++)
-        for (int to = A1; to <= H8; to++) {
-          r[p][fr][to] = val<STAGE>(p, to) - val<STAGE>(p, fr);
-        }
+      for (int sq = A1; sq <= H8; sq++)
+        r[p][sq] = make_score(val<MG>(p, sq), val<EG>(p, sq));
 
     return r;
   }
+  inline constexpr square_t square_pst = make_square_pst();
 
-  static const delta_t delta_pst_mg = make_delta_pst<MG>();
-  static const delta_t delta_pst_eg = make_delta_pst<EG>();
-
-  static consteval int move_score(int p, Move m) {
-    return delta_pst_mg[p][m.fr()][m.to()];
+  static constexpr score_t sq_val(int p, int sq) {
+    return square_pst[p][sq];
+  }
+  static constexpr score_t delta(int p, int fr, int to) {
+    return square_pst[p][to] - square_pst[p][fr];
+  }
+  static constexpr int move_score(int p, Move m) {
+    return mg_value(delta(p, m.fr(), m.to()));
   }
 
   /// piece square table
@@ -254,45 +271,39 @@ namespace pst {
   class Table {
 
    public:
-    constexpr Table() : p_count_(0), score_mg_(0), score_eg_(0) {
+    constexpr Table() : p_count_(0), score_(0) {
     }
-    constexpr Table(const Table& o)
-      : p_count_(o.p_count_), score_mg_(o.score_mg_), score_eg_(o.score_eg_) {
+    constexpr Table(const Table& o) : p_count_(o.p_count_), score_(o.score_) {
     }
     constexpr Table& operator=(const Table& o) {
-      p_count_  = o.p_count_;
-      score_mg_ = o.score_mg_;
-      score_eg_ = o.score_eg_;
+      p_count_ = o.p_count_;
+      score_   = o.score_;
       return *this;
     }
     constexpr void clear() {
-      p_count_  = 0;
-      score_mg_ = 0;
-      score_eg_ = 0;
+      p_count_ = 0;
+      score_   = 0;
     }
     constexpr void push(int p, int sq) {
       assert(p >= BP && p <= WK);
       assert(sq >= A1 && sq <= H8);
 
       p_count_ += P_CNT[p];
-      score_mg_ += val<MG>(p, sq);
-      score_eg_ += val<EG>(p, sq);
+      score_ += sq_val(p, sq);
     }
     constexpr void pop(int p, int sq) {
       assert(p >= BP && p <= WK);
       assert(sq >= A1 && sq <= H8);
 
       p_count_ -= P_CNT[p];
-      score_mg_ -= val<MG>(p, sq);
-      score_eg_ -= val<EG>(p, sq);
+      score_ -= sq_val(p, sq);
     }
     constexpr void move(int p, int fr, int to) {
       assert(p >= BP && p <= WK);
       assert(fr >= A1 && fr <= H8);
       assert(to >= A1 && to <= H8);
 
-      score_mg_ += delta_pst_mg[p][fr][to];
-      score_eg_ += delta_pst_eg[p][fr][to];
+      score_ += delta(p, fr, to);
     }
     constexpr int cnt(int p) const {
       return (p_count_ & P_CNT_MASK[p]) >> SHIFT[p];
@@ -306,13 +317,11 @@ namespace pst {
       // clang-format on
       return (q > 24) ? 24 : q;
     }
-    constexpr int mix() const {
-      int ph = phase();
-      return (mg() * ph + eg() * (24 - ph)) / 24;
-    }
-    constexpr int mix(int m, int e) const {
+    // tapered by phase, s: packed eval terms on top of the pst
+    constexpr int mix(score_t s = 0) const {
       int ph = phase();
-      return ((mg() + m) * ph + (eg() + e) * (24 - ph)) / 24;
+      s += score_;
+      return (mg_value(s) * ph + eg_value(s) * (24 - ph)) / 24;
     }
     constexpr bool null_ok(int side) const {
       return (cnt(side) - cnt((PAWN << 1) | side)) > 2;
@@ -351,15 +360,7 @@ namespace pst {
 
    private:
     uint64_t p_count_;
-    int score_mg_;
-    int score_eg_;
-
-    constexpr int mg() const {
-      return score_mg_;
-    }
-    constexpr int eg() const {
-      return score_eg_;
-    }
+    score_t score_;
   };
 } // namespace pst
 
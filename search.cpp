@@ -29,7 +29,7 @@ void Search::time_check() {
       stop_.store(true);
   }
 }
-void Search::info(int score, int depth, PV& pv) {
+void Search::info(int score, int depth) {
   // clang-format off
   int t = timer_.stop();
   if (std::abs(score) >= MATT_IN_MAX) {
@@ -41,6 +41,7 @@ void Search::info(int score, int depth, PV& pv) {
               << " nodes "      << node_counter_
               << " score mate " << score
               << " nps "        << (node_counter_ * 1000) / (t + 1)
+              << " hashfull "   << table_.hashfull()
               << " time "       << t;
   } else {
     std::cout << "info depth "  << depth
@@ -48,12 +49,39 @@ void Search::info(int score, int depth, PV& pv) {
               << " nodes "      << node_counter_
               << " score cp "   << score
               << " nps "        << (node_counter_ * 1000) / (t + 1)
+              << " hashfull "   << table_.hashfull()
               << " time "       << t;
   }
-  std::cout << " pv " << pv << std::endl;
+  std::cout << " pv ";
+  for (int i = 0; i < pv_len_[0]; ++i)
+    std::cout << pv_[0][i];
+  std::cout << std::endl;
   // clang-format on
 }
-int Search::quiesce(int depth, int alpha, int beta) {
+void Search::ht_info() const {
+  // clang-format off
+  const ht::Stats& s = stats_;
+  std::cout << "info string hash probes " << s.probes
+            << " hits "       << s.hits
+            << " (" << s.hits * 100 / (s.probes + 1) << "%)"
+            << " cutoffs "    << s.cutoffs
+            << " moves "      << s.moves
+            << " stores "     << s.stores
+            << " overwrites " << s.overwrites
+            << " hashfull "   << table_.hashfull() << std::endl;
+  // clang-format on
+}
+// slider lookups of this search per node, make lookups
+void Search::lookups_info() const {
+  const db::Lookups& l = db::lookups;
+  std::cout << "info string lookups " << l.done << " ("
+            << float(l.done) / node_counter_ << "/node) replaced "
+            << l.replaced << " (" << float(l.replaced) / node_counter_
+            << "/node)"
+            << std::endl;
+}
+template <bool S>
+HOT int Search::quiesce(int depth, int alpha, int beta) {
 
   time_check();
   if (pos_.is_draw())
@@ -70,34 +98,30 @@ int Search::quiesce(int depth, int alpha, int beta) {
   if (score > alpha)
     alpha = score;
 
-  move_lists_[ply].clear();
-  gen::G gen(hr_);
-  gen.tactical(move_lists_[ply], pos_, !depth);
-  move_lists_[ply].sort();
+  // losing captures aren't picked
+  gen::Picker picker(hr_, pos_, move_lists_[ply], !depth);
 
   score    = SCORE_NONE;
   u64 done = 0;
+  Move m;
 
-  for (Move m : move_lists_[ply]) {
-
-    if (!is_check && !m.pp()
-        && VALUE[pos_.piece(m.fr())] > VALUE[pos_.piece(m.to())]
-        && pos_.see(m) < 0)
-      continue;
-    if (!is_check && !gen.checked(m) && (bit(m.to()) & done))
-      continue;
-    if (!pos_.do_move(m))
-      continue;
-    if (!is_check && !gen.checked(m))
+  while ((m = picker.next()) != Move::none()) {
+
+    if (!is_check && !picker.gives_check(m)) {
+      if (bit(m.to()) & done)
+        continue;
       done |= bit(m.to());
+    }
+
+    pos_.do_legal<S>(m);
 
     hr_.push();
     sel_depth_ = std::max(ply, sel_depth_);
 
-    score = -quiesce(depth - 1, -beta, -alpha);
+    score = -quiesce<!S>(depth - 1, -beta, -alpha);
 
     hr_.pop();
-    pos_.undo_move();
+    pos_.undo_move<S>();
 
     if (stop_)
       return 0;
@@ -112,7 +136,8 @@ int Search::quiesce(int depth, int alpha, int beta) {
     alpha = -MATT + ply;
   return alpha;
 }
-int Search::alphaBeta(int depth, int alpha, int beta, PV& pv, bool opt) {
+template <bool S>
+HOT int Search::alphaBeta(int depth, int alpha, int beta, bool opt) {
 
   int ply      = hr_.sply();
   bool is_pv   = beta - alpha != 1;
@@ -125,7 +150,7 @@ int Search::alphaBeta(int depth, int alpha, int beta, PV& pv, bool opt) {
   }
 
   if (depth <= 0)
-    return quiesce(0, alpha, beta);
+    return quiesce<S>(0, alpha, beta);
 
   time_check();
 
@@ -135,7 +160,8 @@ int Search::alphaBeta(int depth, int alpha, int beta, PV& pv, bool opt) {
   int score      = SCORE_NONE;
   int best_score = is_root ? alpha : -MATT;
 
-  ht::Entry* entry = nullptr;
+  ht::Entry entry;
+  bool hit = false;
 
   assert(-INF <= alpha && alpha < beta && beta <= INF);
   assert(is_pv || (alpha == beta - 1));
@@ -155,30 +181,35 @@ int Search::alphaBeta(int depth, int alpha, int beta, PV& pv, bool opt) {
   } else
     goto Move_Loop;
 
-  entry = table_.e(key, depth);
+  hit = table_.e(key, depth, entry, stats_);
 
-  if (!is_pv && entry) {
-    score = ht::out(entry->score_, ply, pos_.r50());
+  if (!is_pv && hit) {
+    score = ht::out(entry.score_, ply, pos_.r50());
 
-    if (entry->depth_ >= depth && score != SCORE_NONE && score >= beta
-          ? (entry->flag_ & ht::Entry::LB)
-          : (entry->flag_ & ht::Entry::UB)) {
-      if (pos_.r50() < 90)
+    if (entry.depth() >= depth && score != SCORE_NONE && score >= beta
+          ? (entry.flag() & ht::Entry::LB)
+          : (entry.flag() & ht::Entry::UB)) {
+      if (pos_.r50() < 90) {
+        stats_.cutoffs++;
         return score;
+      }
     }
   }
-  hr_.set_tt_move(table_.move(key));
+  hr_.set_tt_move(table_.move(key, stats_));
 
-  pv.clear();
+  pv_clear(ply);
 
   if (is_check) {
-    eval = -MATT + ply;
+    eval              = -MATT + ply;
+    hr_.ply(ply).eval = SCORE_NONE;
     goto Move_Loop;
-  } else if (last_move() != Move::null())
+  } else if (last_move(ply) != Move::null())
     eval = pos_.eval();
   else
     eval = pos_.eval() + 50;
 
+  hr_.ply(ply).eval = eval;
+
   if (!is_pv && std::abs(beta) < MATT_IN_MAX - 225) {
 
     // beta pruning
@@ -190,17 +221,20 @@ int Search::alphaBeta(int depth, int alpha, int beta, PV& pv, bool opt) {
     }
     // null
     if (opt && eval >= beta && pos_.null_ok()) {
+      table_.prefetch(pos_.key_after_null());
       pos_.do_null();
+
+      // not a move of the line: last_move() & is_recap() look past it
+      hr_.ply(ply).move = hr_.ply(ply - 1).move;
+      hr_.ply(ply).cp   = hr_.ply(ply - 1).cp;
       hr_.push();
 
       int r = (11 + depth) / 3 + std::min(int(eval - beta) / 150, 3);
 
       if (depth <= r)
-        score = -quiesce(0, -beta, -alpha);
-      else {
-        PV npv;
-        score = -alphaBeta(depth - r, -beta, -beta + 1, npv, false);
-      }
+        score = -quiesce<!S>(0, -beta, -alpha);
+      else
+        score = -alphaBeta<!S>(depth - r, -beta, -beta + 1, false);
 
       pos_.undo_null();
       hr_.pop();
@@ -210,8 +244,7 @@ int Search::alphaBeta(int depth, int alpha, int beta, PV& pv, bool opt) {
           assert(score > -INF && score < INF);
           return score;
         }
-        PV npv;
-        int vs = alphaBeta(depth - r, beta - 1, beta, npv, false);
+        int vs = alphaBeta<S>(depth - r, beta - 1, beta, false);
         if (vs >= beta) {
           assert(score > -INF && score < INF);
           return score;
@@ -225,32 +258,31 @@ int Search::alphaBeta(int depth, int alpha, int beta, PV& pv, bool opt) {
 
 Move_Loop:
 
-  move_lists_[ply].clear();
-  gen::G gen(hr_);
-  gen.all(move_lists_[ply], pos_);
-  move_lists_[ply].sort();
+  gen::Picker picker(hr_, pos_, move_lists_[ply]);
 
   int old_alpha  = alpha;
   Move best_move = Move::none();
   int move_cnt   = 0;
+  Move m;
 
   score = SCORE_NONE;
 
   hr_.clear_gc();
 
-  for (Move m : move_lists_[ply]) {
-    PV npv;
+  while ((m = picker.next()) != Move::none()) {
+    table_.prefetch(pos_.key_after(m));
 
     bool is_tactical = pos_.is_tactical(m);
-    bool recap       = !is_root && is_recap(m);
+    bool recap       = !is_root && is_recap(m, ply);
     bool pawn_push   = pos_.is_pawn_push(m);
+    bool gives_check = picker.gives_check(m);
     int capture      = pos_.piece(m.to());
 
-    if (!pos_.do_move(m))
-      continue;
+    pos_.do_legal<S>(m);
 
-    move_line_.push_back(m);
-    cp_line_.push_back(capture);
+    hr_.ply(ply).move = m;
+    hr_.ply(ply).cp   = capture;
+    pv_clear(ply + 1);
 
     move_cnt++;
     hr_.push();
@@ -267,14 +299,15 @@ Move_Loop:
 
     if (!is_root && cur_depth_ >= 6) {
 
-      recap &= is_tactical ? -quiesce(0, -alpha - 1, -alpha) > alpha : false;
+      recap &= is_tactical ? -quiesce<!S>(0, -alpha - 1, -alpha) > alpha : false;
 
       if ((is_pv && (is_check || recap || pawn_push))
           || (depth <= 4 && (is_check || recap)))
         ext = 1;
 
-      else if (depth >= 3 && leave_pv && !is_tactical && !is_check && !m.is_00()
-               && !pawn_push && !recap && m.sc() < -(depth * depth)
+      else if (depth >= 3 && leave_pv && !is_tactical && !is_check
+               && !gives_check && !m.is_00() && !pawn_push && !recap
+               && m.sc() < std::max(-(depth * depth), INT16_MIN)
                && std::abs(eval) < MATT_IN_MAX) {
 
         red = depth / 3;
@@ -282,18 +315,15 @@ Move_Loop:
     }
 
     if ((is_pv && leave_pv) || red) {
-      score = -alphaBeta(depth + ext - red - 1, -alpha - 1, -alpha, npv, opt);
+      score = -alphaBeta<!S>(depth + ext - red - 1, -alpha - 1, -alpha, opt);
       if (score > alpha)
-        score = -alphaBeta(depth + ext - 1, -beta, -alpha, npv, opt);
+        score = -alphaBeta<!S>(depth + ext - 1, -beta, -alpha, opt);
     } else {
-      score = -alphaBeta(depth + ext - 1, -beta, -alpha, npv, opt);
+      score = -alphaBeta<!S>(depth + ext - 1, -beta, -alpha, opt);
     }
 
     hr_.pop();
-    pos_.undo_move();
-
-    move_line_.pop_back();
-    cp_line_.pop_back();
+    pos_.undo_move<S>();
 
     if (!is_tactical) {
       hr_.process_serchinfo(
@@ -310,15 +340,17 @@ Move_Loop:
         best_move = m;
 
         if (is_pv) {
-          pv.replace(m, npv);
+          pv_update(ply, m);
           if (is_root) {
-            info(best_score, depth, pv);
+            info(best_score, depth);
           }
         }
 
         if (score >= beta) {
-          for (auto x : move_lists_[ply]) {
-            if (x != m && !pos_.is_tactical(x))
+          // the quiets searched before m
+          for (int i = 0; i < picker.quiets_size(); ++i) {
+            Move x(picker.quiets()[i]);
+            if (x.frto() != m.frto())
               hr_.add_history(
                 x.frto(), pos_.piece(x.fr()), -(depth >> 1));
           }
@@ -333,12 +365,14 @@ Move_Loop:
 
   if (!is_root) {
     if (best_score >= beta)
-      table_.rem(key, best_move, depth, ht::in(best_score, ply), ht::Entry::LB);
+      table_.rem(key, best_move, depth, ht::in(best_score, ply),
+                 ht::Entry::LB, stats_);
     else if (is_pv && best_score > old_alpha)
-      table_.rem(key, best_move, depth, ht::in(best_score, ply), ht::Entry::XB);
+      table_.rem(key, best_move, depth, ht::in(best_score, ply),
+                 ht::Entry::XB, stats_);
     else
-      table_.rem(
-        key, Move::none(), depth, ht::in(best_score, ply), ht::Entry::UB);
+      table_.rem(key, Move::none(), depth, ht::in(best_score, ply),
+                 ht::Entry::UB, stats_);
   }
   return best_score;
 }
@@ -346,11 +380,15 @@ void Search::init() {
 
   timer_.reset();
   hr_.clear();
-  cp_line_.clear();
-  move_line_.clear();
-  // 2do table_.reset();
+  // run() falls back to pv_[0][0], none of the last search
+  pv_clear(0);
+  pv_[0][0] = Move::none();
+  table_.new_search();
+  stats_ = ht::Stats();
   stop_.store(false);
   node_counter_ = 1;
+  allocs_       = mem::allocs();
+  db::lookups   = db::Lookups();
 }
 Move Search::run() {
 
@@ -363,7 +401,6 @@ Move Search::run() {
   int delta     = 17;
 
   Move bm = Move::none();
-  PV pv;
 
   for (cur_depth_ = 1; cur_depth_ < MAX_DEPTH; cur_depth_++) {
     if (cur_depth_ >= 6) {
@@ -381,12 +418,13 @@ Move Search::run() {
         beta = MATT;
 
       sel_depth_ = 0;
-      pv.clear();
+      pv_clear(0);
 
-      score = alphaBeta(depth, alpha, beta, pv, true);
+      score = pos_.side() ? alphaBeta<W_>(depth, alpha, beta, true)
+                          : alphaBeta<B_>(depth, alpha, beta, true);
 
-      if (pv[0] != bm) {
-        bm = pv[0];
+      if (pv_[0][0] != bm) {
+        bm = pv_[0][0];
         if (base_time > 30000 && pos_.ply() > 12)
           time_ += std::abs(score) < 1000
                    ? (base_time + time_inc_) / 100 * cur_depth_
@@ -397,8 +435,8 @@ Move Search::run() {
       if (stop_) {
         if (bm != Move::none())
           return bm;
-        else if (pv[0] != Move::none())
-          return pv[0];
+        else if (pv_[0][0] != Move::none())
+          return pv_[0][0];
       }
 
       if (score <= alpha) {
@@ -413,7 +451,7 @@ Move Search::run() {
       delta += (delta >> 2) + 5;
     }
 
-    if (stop_ && (bm != Move::none() || pv[0] != Move::none()))
+    if (stop_ && (bm != Move::none() || pv_[0][0] != Move::none()))
       break;
   }
   return bm;
@@ -445,7 +483,9 @@ namespace perft {
     { 1, 46, 2079, 89890, 3894594, 164075551 }
   };
 
-  uint64_t perft(int depth, core::Pos& p) {
+  // side to move S: one dispatch per node, none per move
+  template <bool S>
+  HOT uint64_t perft(int depth, core::Pos& p) {
 
     uint64_t nodes = 0;
     if (depth == 0)
@@ -458,14 +498,20 @@ namespace perft {
     gen::G gen(not_used); // & with
     gen.all(ml, p);       // gen::G()
 
+    // legal moves: bulk count the last ply
+    if (depth == 1)
+      return ml.size();
+
     for (Move m : ml) {
-      if (!p.do_move(m))
-        continue;
-      nodes += perft(depth - 1, p);
-      p.undo_move();
+      p.do_legal<S>(m);
+      nodes += perft<!S>(depth - 1, p);
+      p.undo_move<S>();
     }
     return nodes;
   }
+  uint64_t perft(int depth, core::Pos& p) {
+    return p.side() ? perft<W_>(depth, p) : perft<B_>(depth, p);
+  }
 
   void run() {
 
@@ -514,4 +560,36 @@ namespace perft {
     std::cout << "total nodes " << moves << " in "
               << (float(all_time) / 1000.0f) << " s" << std::endl;
   }
+
+  // generator micro benchmark: a fresh gen::G per call, as in search
+  void bench() {
+
+    constexpr int N = 200'000;
+    uint64_t sum[3] = { 0, 0, 0 }, time[3] = { 0, 0, 0 };
+    MoveList ml;
+
+    for (int p = 0; p < 7; p++) {
+      core::Pos position(PERFT[p]);
+
+      for (int k = 0; k < 3; k++) {
+        Timer timer;
+        timer.reset();
+        for (int i = 0; i < N; ++i) {
+          ml.clear();
+          gen::G gen(not_used);
+          if (k == 0)
+            gen.all(ml, position);
+          else
+            gen.tactical(ml, position, k == 2);
+          sum[k] += ml.size();
+        }
+        time[k] += timer.stop();
+      }
+    }
+
+    const char* name[3] = { "all", "tactical", "tactical+checks" };
+    for (int k = 0; k < 3; k++)
+      std::cout << name[k] << ": " << time[k] * 1'000'000 / (7 * N)
+                << " ns / call (" << sum[k] << " moves)" << std::endl;
+  }
 } // namespace perft
@@ -34,10 +34,20 @@ class Search {
 
   void init();
   Move run();
+  void ht_info() const;
+  void lookups_info() const;
 
-  bool stopped() {
+  bool stopped() const {
     return stop_;
   }
+  // from go until the search thread is done with the table,
+  // stopped() is already true while it unwinds
+  bool running() const {
+    return running_;
+  }
+  void set_running(bool r) {
+    running_.store(r);
+  }
   void set_time(int msecs) {
     time_ = msecs;
   }
@@ -50,37 +60,81 @@ class Search {
   void set_stop(bool s = true) {
     stop_.store(s);
   }
-  void clear_ht() {
-    table_.clear();
+  void clear_ht(int threads = 1) {
+    table_.clear(threads);
+  }
+  // snapshots & new tables, refused while a search may probe the table
+  bool save_ht(const std::string& file) const {
+    return !running() && table_.write(file);
+  }
+  bool load_ht(const std::string& file) {
+    return !running() && table_.read(file);
+  }
+  bool set_hash(int mb) {
+    return !running() && table_.resize(mb);
+  }
+  bool set_shared_hash(const std::string& name) {
+    return !running() && table_.share(name);
+  }
+  bool shared_hash() const {
+    return table_.shared();
+  }
+  // heap allocations of the search thread since init()
+  uint64_t allocs() const {
+    return mem::allocs() - allocs_;
+  }
+  bool set_large_pages(bool on) {
+    return !running() && table_.resize(table_.size_mb(), on);
+  }
+  mem::Pages hash_pages() const {
+    return table_.pages();
   }
 
  private:
-  bool is_recap(Move m) {
-    return move_line_.back().to() == m.to() && cp_line_.back();
+  // the move that led to ply
+  bool is_recap(Move m, int ply) {
+    const gen::Ply& p = hr_.ply(ply - 1);
+    return p.move.to() == m.to() && p.cp;
   }
-  Move last_move() {
-    return move_line_.back();
+  Move last_move(int ply) {
+    return hr_.ply(ply - 1).move;
   }
   int draw_value() {
     return 2 * (node_counter_ & 1) - 1;
   }
-  void info(int score, int depth, PV& pv);
+  // triangular pv: pv_[ply][ply, pv_len_[ply])
+  void pv_clear(int ply) {
+    pv_len_[ply] = ply;
+  }
+  void pv_update(int ply, Move m) {
+    pv_[ply][ply] = m;
+    for (int i = ply + 1; i < pv_len_[ply + 1]; ++i)
+      pv_[ply][i] = pv_[ply + 1][i];
+    pv_len_[ply] = pv_len_[ply + 1];
+  }
+  void info(int score, int depth);
   void time_check();
+  // S: the side to move, one make/unmake dispatch per node
+  template <bool S>
   int quiesce(int depth, int alpha, int beta);
-  int alphaBeta(int depth, int alpha, int beta, PV& pv, bool opt);
+  template <bool S>
+  int alphaBeta(int depth, int alpha, int beta, bool opt);
 
   core::Pos& pos_;
 
   std::array<MoveList, MAX_DEPTH> move_lists_;
-  std::vector<Move> move_line_;
-  std::vector<uint8_t> cp_line_;
+  std::array<std::array<Move, MAX_DEPTH + 1>, MAX_DEPTH + 1> pv_;
+  std::array<int, MAX_DEPTH + 1> pv_len_;
 
   gen::Heuristic hr_;
   ht::Table table_;
+  ht::Stats stats_; // of this search, HashStats
   Timer timer_;
-  std::atomic<bool> stop_;
+  std::atomic<bool> stop_{ true }; // no search running
+  std::atomic<bool> running_{ false };
 
   uint64_t node_counter_ = 1;
+  uint64_t allocs_       = 0;
   int time_              = 1;
   int time_inc_          = 0;
   int cur_depth_         = 0;
@@ -92,6 +146,7 @@ namespace perft {
 
   uint64_t perft(int depth, core::Pos& p);
   void run();
+  void bench();
 } // namespace perft
 
 #endif
\ No newline at end of file
@@ -31,6 +31,10 @@ namespace uci {
   core::Pos position(fen::new_game);
   Search search_(position);
 
+  bool large_pages      = true;
+  bool hash_stats       = false;
+  mem::Pages atck_pages = mem::SMALL;
+
   bool log(const Move m) {
 
     std::fstream file(".log.txt", std::ios::app);
@@ -43,8 +47,20 @@ namespace uci {
   void search() {
 
     Move m = search_.run();
+    // done, also @max depth: the table is free again
+    search_.set_stop(true);
+    if (hash_stats)
+      search_.ht_info();
+#ifdef COUNT_ALLOCS
+    std::cout << "info string allocations " << search_.allocs() << std::endl;
+#endif
+#ifdef COUNT_LOOKUPS
+    search_.lookups_info();
+#endif
     position.do_move(m);
     std::cout << "bestmove " << m << std::endl;
+    // last: setoption may now replace the tables
+    search_.set_running(false);
   }
   void pos(std::istringstream& is) {
 
@@ -127,13 +143,69 @@ namespace uci {
     search_.set_stop(false);
   }
   void ng() {
+    Timer t;
     position.set(fen::new_game);
-    search_.clear_ht();
+
+    // other engines still use it
+    if (search_.shared_hash())
+      return;
+    search_.clear_ht(std::thread::hardware_concurrency());
+    std::cout << "info string Hash cleared in " << t.stop() << " ms"
+              << std::endl;
+  }
+  void option(std::istringstream& is) {
+
+    std::string str("");
+    std::string name("");
+    std::string value("");
+
+    // setoption name <id> [value <x>]
+    is >> str;
+    while (is >> str && str != "value")
+      name += (name.empty() ? "" : " ") + str;
+    while (is >> str)
+      value += (value.empty() ? "" : " ") + str;
+
+    if (name == "Hash") {
+      if (!search_.set_hash(std::atoi(value.c_str())))
+        std::cout << "info string Hash " << value << " MB failed" << std::endl;
+    } else if (name == "LargePages") {
+      // the attack tables are remapped too
+      if (search_.running()) {
+        std::cout << "info string LargePages failed" << std::endl;
+        return;
+      }
+      large_pages = value == "true";
+      atck_pages  = db::init(large_pages);
+      search_.set_large_pages(large_pages);
+      pages();
+    } else if (name == "SharedHash") {
+      if (!search_.set_shared_hash(value == "<empty>" ? "" : value))
+        std::cout << "info string SharedHash " << value << " failed"
+                  << std::endl;
+    } else if (name == "HashStats")
+      hash_stats = value == "true";
+    else
+      unknown("setoption name " + name);
+  }
+  void pages() {
+    std::cout << "info string LargePages hash "
+              << mem::name(search_.hash_pages()) << " attacks "
+              << mem::name(atck_pages) << std::endl;
   }
   void uci() {
     std::cout << "id name Bienchen" << std::endl
               << "id author Manuel Schenske" << std::endl
-              << "uciok" << std::endl;
+              << "option name Hash type spin default " << ht::HASH_MB
+              << " min " << ht::HASH_MIN << " max " << ht::HASH_MAX
+              << std::endl
+              << "option name LargePages type check default true" << std::endl
+              << "option name HashStats type check default false" << std::endl
+              << "option name SharedHash type string default <empty>"
+              << std::endl;
+    pages();
+    std::cout << "info string CPU " << cpu::path() << std::endl;
+    std::cout << "uciok" << std::endl;
   }
   void rdy() {
     std::cout << "readyok" << std::endl;
@@ -143,6 +215,7 @@ namespace uci {
   }
   void run() {
 
+    atck_pages = db::init(large_pages);
     position.set(fen::new_game);
     std::string str("");
     std::string cmd("");
@@ -168,15 +241,31 @@ namespace uci {
         uci();
       else if (str == "ucinewgame")
         ng();
+      else if (str == "setoption")
+        option(is);
       else if (str == "isready")
         rdy();
       else if (str == "go") {
         go(is);
+        search_.set_running(true);
         v.emplace_back(std::thread(search));
       } else if (str == "position")
         pos(is);
       else if (str == "perft") {
         v.emplace_back(std::thread(perft::run));
+      } else if (str == "genbench") {
+        v.emplace_back(std::thread(perft::bench));
+      } else if (str == "hashtest") {
+        int n = std::thread::hardware_concurrency();
+        is >> n;
+        ht::stress(std::max(n, 1));
+      } else if (str == "savehash" || str == "loadhash") {
+        std::string file;
+        std::getline(is >> std::ws, file);
+        bool ok = str == "savehash" ? search_.save_ht(file)
+                                    : search_.load_ht(file);
+        std::cout << "info string " << str << " " << file
+                  << (ok ? " ok" : " failed") << std::endl;
       } else if (str == "print")
         std::cout << position << std::endl;
       else
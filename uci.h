@@ -29,6 +29,8 @@ namespace uci {
   void pos(std::istringstream& is);
   void go(std::istringstream& is);
   void ng();
+  void option(std::istringstream& is);
+  void pages();
   void uci();
   void rdy();
   void unknown(const std::string& cmd);